@@ -0,0 +1,165 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Columns of one line of the iteration log
+ */
+struct IterationLogEntry {
+  uint32_t robotID;
+  uint32_t clusterID;
+  uint32_t numActiveRobots;
+  uint32_t iteration;
+  uint64_t numPoses;
+  uint64_t bytesReceived;
+  uint64_t bytesSent;
+  double iterTimeSec;
+  double totalTimeSec;
+  double relChange;
+  double quantizationError;
+};
+
+/**
+ * @brief Fixed-size record of the binary iteration log. A text line longer than the
+ * record is split over several records.
+ */
+struct IterationLogRecord {
+  enum Type : uint32_t {
+    Iteration = 1,     // One line of the iteration log
+    Text = 2,          // Last (or only) part of a text line
+    TextContinued = 3  // Part of a text line continued in the next record
+  };
+  static constexpr size_t kMaxTextLength = 120;
+
+  uint32_t type;
+  // Number of characters in text (only used by text records)
+  uint32_t textLength;
+  union {
+    IterationLogEntry iteration;
+    char text[kMaxTextLength];
+  };
+};
+static_assert(std::is_trivially_copyable<IterationLogRecord>::value,
+              "IterationLogRecord is written to the binary log as is");
+static_assert(sizeof(IterationLogRecord) == 128, "Unexpected binary log record size");
+
+/**
+ * @brief Write the column names of the iteration log in CSV format
+ */
+void writeIterationLogHeader(std::ostream &os);
+
+/**
+ * @brief Write one line of the iteration log in CSV format
+ */
+void writeIterationLogEntry(std::ostream &os, const IterationLogEntry &entry);
+
+/**
+ * @brief Iteration log that moves file I/O off the optimization thread. Records are
+ * pushed into a lock-free single-producer single-consumer ring buffer, and a
+ * background thread writes them to the file in batches. Records are written in binary
+ * and can be converted to the CSV iteration log with convertBinaryIterationLog.
+ *
+ * Calls to push, logIteration, logString and flush must not be concurrent (PGOAgentROS
+ * calls them while holding the agent mutex).
+ */
+class AsyncBinaryLogger {
+ public:
+  /**
+   * @brief Constructor
+   * @param capacity number of records in the ring buffer (rounded up to a power of 2)
+   */
+  explicit AsyncBinaryLogger(size_t capacity = 4096);
+  ~AsyncBinaryLogger();
+  AsyncBinaryLogger(const AsyncBinaryLogger &) = delete;
+  AsyncBinaryLogger &operator=(const AsyncBinaryLogger &) = delete;
+
+  /**
+   * @brief Create the log file and start the writer thread. An open log is closed
+   * first.
+   * @param filename
+   * @return false if the file cannot be created
+   */
+  bool open(const std::string &filename);
+
+  /**
+   * @brief Write all pending records, then close the file and stop the writer thread
+   */
+  void close();
+
+  bool isOpen() const { return mFile != nullptr; }
+
+  /**
+   * @brief Add a record to the log. Only waits if the ring buffer is full.
+   */
+  void push(const IterationLogRecord &record);
+
+  void logIteration(const IterationLogEntry &entry);
+  void logString(const std::string &str);
+
+  /**
+   * @brief Block until all records pushed so far are written to the file
+   */
+  void flush();
+
+  /**
+   * @brief Number of times push waited for the writer thread because the ring buffer
+   * was full
+   */
+  size_t numStalls() const { return mNumStalls; }
+
+ private:
+  void writerLoop();
+
+  // Write all records pushed so far (only called by the writer thread)
+  void writePending();
+
+  std::vector<IterationLogRecord> mBuffer;
+  const size_t mMask;
+
+  // Index of the next record to push (only modified by the producer)
+  alignas(64) std::atomic<size_t> mHead;
+  // Index of the next record to write (only modified by the writer thread)
+  alignas(64) std::atomic<size_t> mTail;
+
+  std::FILE *mFile;
+  std::thread mWriterThread;
+  size_t mNumStalls;
+
+  // Used to wake up the writer thread and to wait for flushes (only locked by push if
+  // the ring buffer is full)
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mStopRequested;
+  bool mFlushRequested;
+  size_t mFlushedTail;
+};
+
+/**
+ * @brief Convert a binary iteration log written by AsyncBinaryLogger to the CSV
+ * iteration log
+ * @param binary_file
+ * @param csv_file
+ * @return false if the binary log cannot be read or the CSV file cannot be written
+ */
+bool convertBinaryIterationLog(const std::string &binary_file,
+                               const std::string &csv_file);
+
+}  // namespace dpgo_ros
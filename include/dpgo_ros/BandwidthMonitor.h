@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Count the serialized bytes and messages exchanged with other robots, per
+ * topic, peer robot and direction
+ */
+class BandwidthMonitor {
+ public:
+  enum class Direction { Sent, Received };
+
+  // Peer of messages that are not addressed to a single robot (e.g., status)
+  static constexpr int kAllRobots = -1;
+
+  struct LinkStatistics {
+    Direction direction;
+    std::string topic;
+    int peer;
+    // Totals since construction or the latest clear
+    uint64_t bytes;
+    uint64_t messages;
+    // Rates since the previous call to statistics
+    double bytesPerSec;
+    double messagesPerSec;
+  };
+
+  /**
+   * @brief Count one message
+   * @param direction
+   * @param topic
+   * @param peer destination robot of sent messages, or source robot of received
+   * messages (kAllRobots if the message is not addressed to a single robot)
+   * @param bytes serialized size of the message
+   */
+  void record(Direction direction, const std::string &topic, int peer, uint64_t bytes);
+
+  /**
+   * @brief Total bytes in the given direction over all topics and peers
+   */
+  uint64_t totalBytes(Direction direction) const;
+
+  /**
+   * @brief Counters of all links, with rates computed since the previous call
+   * @param time_sec current time in seconds
+   * @return
+   */
+  std::vector<LinkStatistics> statistics(double time_sec);
+
+  /**
+   * @brief Reset all counters
+   */
+  void clear();
+
+  inline static std::string directionToString(Direction direction) {
+    return direction == Direction::Sent ? "sent" : "received";
+  }
+
+ private:
+  struct Counter {
+    uint64_t bytes = 0;
+    uint64_t messages = 0;
+  };
+  typedef std::tuple<Direction, std::string, int> LinkKey;
+
+  std::map<LinkKey, Counter> mCounters;
+  std::map<LinkKey, Counter> mPreviousCounters;
+  std::optional<double> mPreviousTimeSec;
+  uint64_t mTotalBytesSent = 0;
+  uint64_t mTotalBytesReceived = 0;
+};
+
+}  // namespace dpgo_ros
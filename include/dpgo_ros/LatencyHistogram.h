@@ -0,0 +1,74 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Histogram of latencies with logarithmically spaced buckets (8 per doubling,
+ * from 1 microsecond to about 18 minutes). Percentiles are accurate to about 5%
+ * relative error, with constant memory and constant time per sample.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  /**
+   * @brief Add a sample
+   * @param ms latency in milliseconds
+   */
+  void record(double ms);
+
+  /**
+   * @brief Remove all samples
+   */
+  void clear();
+
+  size_t count() const { return mCount; }
+  double meanMs() const { return mCount == 0 ? 0 : mSumMs / mCount; }
+  double maxMs() const { return mMaxMs; }
+
+  /**
+   * @brief Approximate percentile of the samples
+   * @param q quantile in [0, 1] (e.g., 0.95)
+   * @return latency in milliseconds (0 without samples)
+   */
+  double percentileMs(double q) const;
+
+ private:
+  std::vector<size_t> mBuckets;
+  size_t mCount;
+  double mSumMs;
+  double mMinMs;
+  double mMaxMs;
+};
+
+/**
+ * @brief Record the time elapsed between construction and destruction into a histogram
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(LatencyHistogram &histogram)
+      : mHistogram(histogram), mStart(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    const auto elapsed = std::chrono::steady_clock::now() - mStart;
+    mHistogram.record(std::chrono::duration<double, std::milli>(elapsed).count());
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  LatencyHistogram &mHistogram;
+  const std::chrono::steady_clock::time_point mStart;
+};
+
+}  // namespace dpgo_ros
@@ -9,11 +9,19 @@
 #define PGOAGENTROS_H
 
 #include <DPGO/PGOAgent.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <dpgo_ros/AsyncBinaryLogger.h>
+#include <dpgo_ros/BandwidthMonitor.h>
 #include <dpgo_ros/Command.h>
+#include <dpgo_ros/LatencyHistogram.h>
+#include <dpgo_ros/PackedPublicPoses.h>
+#include <dpgo_ros/PoseGraphROS.h>
 #include <dpgo_ros/PublicPoses.h>
 #include <dpgo_ros/QueryLiftingMatrix.h>
+#include <dpgo_ros/QueryPoseGraphDelta.h>
 #include <dpgo_ros/RelativeMeasurementList.h>
 #include <dpgo_ros/RelativeMeasurementWeights.h>
+#include <dpgo_ros/SharedLoopClosureTracker.h>
 #include <dpgo_ros/Status.h>
 #include <pose_graph_tools_msgs/PoseGraph.h>
 #include <ros/console.h>
@@ -21,6 +29,15 @@
 #include <std_msgs/UInt16MultiArray.h>
 #include <visualization_msgs/Marker.h>
 
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <unordered_set>
+
 using namespace DPGO;
 
 namespace dpgo_ros {
@@ -33,25 +50,70 @@ typedef std::vector<ros::Subscriber> SubscriberVector;
 class PGOAgentROSParameters : public PGOAgentParameters {
  public:
   enum class UpdateRule {
-    Uniform,    // Uniform sampling
-    RoundRobin  // Round robin
+    Uniform,     // Uniform sampling
+    RoundRobin,  // Round robin
+    Coloring,    // Robots with the same color in the neighbor graph update concurrently
+    Greedy,      // Robot with the largest gradient norm
+    Importance   // Sampling with probability proportional to gradient norm
+  };
+
+  enum class PublicPosesFormat {
+    Matrix,  // One MatrixMsg per public pose (PublicPoses)
+    Packed   // Single contiguous buffer for all public poses (PackedPublicPoses)
+  };
+
+  enum class PublicPosesEncoding {
+    Float64,  // Lossless
+    Float32,  // Single precision floating point
+    Fixed16   // 16-bit fixed point with a per-message scale
   };
 
   // Rule to select the next robot for update
   UpdateRule updateRule;
 
+  // Message format used to publish public poses
+  PublicPosesFormat publicPosesFormat;
+
+  // Encoding of public poses (only used by the Packed format)
+  PublicPosesEncoding publicPosesEncoding;
+
+  // Maximum absolute error of each value of the encoded public poses
+  double publicPosesMaxQuantizationError;
+
   // Publish intermediate iterates during optimization
   bool publishIterate;
 
   // If true dpgo will publish loop closure as ROS markers
   bool visualizeLoopClosures;
 
+  // Also publish a decimated trajectory on separate topics, with only the poses that
+  // moved more than this distance (meters) or rotated more than this angle (radians)
+  // since the previous published pose (non-positive values disable decimation)
+  double trajectoryDecimationDistance;
+  double trajectoryDecimationAngle;
+
+  // Maximum rate (Hz) at which iterates are published during optimization
+  // (non-positive value disables the limit)
+  double maxTrajectoryPublishRate;
+
   // Completely reset dpgo after each distributed optimization round
   bool completeReset;
 
   // Synchronize shared measurements between robots before each optimization round
   bool synchronizeMeasurements;
 
+  // Advance distributed initialization as soon as pose graphs, shared loop closures,
+  // lifting matrix and status messages arrive (the timer is only used for retries)
+  bool eventDrivenInitialization;
+
+  // Start each optimization round from the solution of the previous round, instead of
+  // local and distributed initialization (new poses are initialized with odometry)
+  bool warmStart;
+
+  // Only request the edges and nodes added to the local pose graph since the last
+  // request (falls back to the full pose graph if the front end does not support it)
+  bool incrementalPoseGraph;
+
   // Let dpgo try to recover if some robots disconnect during distributed optimization
   bool enableRecovery;
 
@@ -67,23 +129,77 @@ class PGOAgentROSParameters : public PGOAgentParameters {
   // Sleep time before telling next robot to update during optimization
   double interUpdateSleepTime;
 
+  // Replace the fixed inter update sleep by a delay estimated from the measured
+  // message latency (interUpdateSleepTime is used as the upper bound)
+  bool adaptiveUpdatePacing;
+
+  // Publish public poses and the next UPDATE command right after local optimization,
+  // before publishing status, iterate and logs
+  bool pipelineUpdateCommands;
+
+  // Only publish public poses that changed by more than this tolerance since the last
+  // time they were sent (negative value disables delta encoding)
+  double publicPosesChangeTolerance;
+
+  // Maximum number of delta public poses (or measurement weights) messages between two
+  // full messages
+  int publicPosesKeyframeInterval;
+
   // Maximum time in seconds before considering a robot disconnected
   double timeoutThreshold;
 
+  // Run local optimization on a dedicated worker thread, while ROS callbacks are
+  // handled by a multi-threaded spinner
+  bool optimizationThread;
+
+  // Publish public poses, shared loop closures and measurement weights on a separate
+  // topic for each receiving robot, so that robots only receive messages addressed to
+  // them
+  bool perDestinationTopics;
+
+  // Publish latency histograms of each phase of an iteration on the diagnostics topic
+  bool latencyDiagnostics;
+
+  // Publish serialized bytes and message rates per topic and peer robot on the
+  // diagnostics topic
+  bool bandwidthDiagnostics;
+
+  // Write the iteration log in binary from a background thread instead of flushing a
+  // CSV file after every line (convert with dpgo_ros_log_converter)
+  bool binaryLog;
+
   // Default constructor
   PGOAgentROSParameters(unsigned dIn, unsigned rIn, unsigned numRobotsIn)
       : PGOAgentParameters(dIn, rIn, numRobotsIn),
         updateRule(UpdateRule::Uniform),
+        publicPosesFormat(PublicPosesFormat::Matrix),
+        publicPosesEncoding(PublicPosesEncoding::Float64),
+        publicPosesMaxQuantizationError(1e-3),
         publishIterate(false),
         visualizeLoopClosures(false),
+        trajectoryDecimationDistance(0),
+        trajectoryDecimationAngle(0),
+        maxTrajectoryPublishRate(0),
         completeReset(false),
         synchronizeMeasurements(true),
+        eventDrivenInitialization(false),
+        warmStart(false),
+        incrementalPoseGraph(false),
         enableRecovery(true),
         maxDistributedInitSteps(30),
         maxDelayedIterations(3),
         weightConvergenceThreshold(1e-6),
         interUpdateSleepTime(0),
-        timeoutThreshold(15) {}
+        adaptiveUpdatePacing(false),
+        pipelineUpdateCommands(false),
+        publicPosesChangeTolerance(-1),
+        publicPosesKeyframeInterval(10),
+        timeoutThreshold(15),
+        optimizationThread(false),
+        perDestinationTopics(false),
+        latencyDiagnostics(false),
+        bandwidthDiagnostics(false),
+        binaryLog(false) {}
 
   inline friend std::ostream &operator<<(std::ostream &os,
                                          const PGOAgentROSParameters &params) {
@@ -92,17 +208,44 @@ class PGOAgentROSParameters : public PGOAgentParameters {
     // Then print additional options defined in the derived class
     os << "PGOAgentROS parameters: " << std::endl;
     os << "Update rule: " << updateRuleToString(params.updateRule) << std::endl;
+    os << "Public poses format: " << publicPosesFormatToString(params.publicPosesFormat)
+       << std::endl;
+    os << "Public poses encoding: "
+       << publicPosesEncodingToString(params.publicPosesEncoding) << std::endl;
+    os << "Public poses maximum quantization error: "
+       << params.publicPosesMaxQuantizationError << std::endl;
     os << "Publish iterate: " << params.publishIterate << std::endl;
     os << "Visualize loop closures: " << params.visualizeLoopClosures << std::endl;
+    os << "Trajectory decimation distance: " << params.trajectoryDecimationDistance
+       << std::endl;
+    os << "Trajectory decimation angle: " << params.trajectoryDecimationAngle
+       << std::endl;
+    os << "Maximum trajectory publish rate: " << params.maxTrajectoryPublishRate
+       << std::endl;
     os << "Complete reset: " << params.completeReset << std::endl;
     os << "Enable recovery: " << params.enableRecovery << std::endl;
     os << "Synchronize measurements: " << params.synchronizeMeasurements << std::endl;
+    os << "Event-driven initialization: " << params.eventDrivenInitialization
+       << std::endl;
+    os << "Warm start: " << params.warmStart << std::endl;
+    os << "Incremental pose graph: " << params.incrementalPoseGraph << std::endl;
     os << "Maximum distributed initialization attempts: "
        << params.maxDistributedInitSteps << std::endl;
     os << "Maximum delayed iterations: " << params.maxDelayedIterations << std::endl;
     os << "Measurement weight convergence threshold: "
        << params.weightConvergenceThreshold << std::endl;
     os << "Inter update sleep time: " << params.interUpdateSleepTime << std::endl;
+    os << "Adaptive update pacing: " << params.adaptiveUpdatePacing << std::endl;
+    os << "Pipeline update commands: " << params.pipelineUpdateCommands << std::endl;
+    os << "Public poses change tolerance: " << params.publicPosesChangeTolerance
+       << std::endl;
+    os << "Public poses keyframe interval: " << params.publicPosesKeyframeInterval
+       << std::endl;
+    os << "Optimization thread: " << params.optimizationThread << std::endl;
+    os << "Per-destination topics: " << params.perDestinationTopics << std::endl;
+    os << "Latency diagnostics: " << params.latencyDiagnostics << std::endl;
+    os << "Bandwidth diagnostics: " << params.bandwidthDiagnostics << std::endl;
+    os << "Binary log: " << params.binaryLog << std::endl;
     os << "Timeout threshold: " << params.timeoutThreshold << std::endl;
     return os;
   }
@@ -115,24 +258,89 @@ class PGOAgentROSParameters : public PGOAgentParameters {
       case UpdateRule::RoundRobin: {
         return "RoundRobin";
       }
+      case UpdateRule::Coloring: {
+        return "Coloring";
+      }
+      case UpdateRule::Greedy: {
+        return "Greedy";
+      }
+      case UpdateRule::Importance: {
+        return "Importance";
+      }
+    }
+    return "";
+  }
+
+  inline static std::string publicPosesFormatToString(PublicPosesFormat format) {
+    switch (format) {
+      case PublicPosesFormat::Matrix: {
+        return "Matrix";
+      }
+      case PublicPosesFormat::Packed: {
+        return "Packed";
+      }
+    }
+    return "";
+  }
+
+  inline static std::string publicPosesEncodingToString(PublicPosesEncoding encoding) {
+    switch (encoding) {
+      case PublicPosesEncoding::Float64: {
+        return "Float64";
+      }
+      case PublicPosesEncoding::Float32: {
+        return "Float32";
+      }
+      case PublicPosesEncoding::Fixed16: {
+        return "Fixed16";
+      }
     }
     return "";
   }
 };
 
+/**
+ * @brief Load the agent ID and parameters from the private namespace of a node
+ * @param nh_private private node handle
+ * @param ID output agent ID
+ * @return agent parameters, or std::nullopt if a parameter is missing or invalid
+ */
+std::optional<PGOAgentROSParameters> loadPGOAgentROSParameters(
+    const ros::NodeHandle &nh_private, unsigned &ID);
+
 class PGOAgentROS : public PGOAgent {
  public:
+  /**
+   * @brief Constructor
+   * @param nh_ node handle used for topics and timers
+   * @param ID agent ID
+   * @param params agent parameters
+   * @param nh_private_ node handle of the private namespace (robot names, random seed)
+   */
   PGOAgentROS(const ros::NodeHandle &nh_,
               unsigned ID,
-              const PGOAgentROSParameters &params);
+              const PGOAgentROSParameters &params,
+              const ros::NodeHandle &nh_private_ = ros::NodeHandle("~"));
 
-  ~PGOAgentROS() = default;
+  ~PGOAgentROS();
 
   /**
    * @brief Function to be called at every ROS spin.
    */
   void runOnce();
 
+  /**
+   * @brief Start a worker thread that calls runOnce() as soon as this agent is ready
+   * to iterate. When the worker is running, ROS callbacks of this agent can be
+   * handled by a multi-threaded spinner.
+   */
+  void startOptimizationWorker();
+
+  /**
+   * @brief Stop the worker thread started by startOptimizationWorker()
+   */
+  void stopOptimizationWorker();
+
  private:
   // ROS node handle
   ros::NodeHandle nh;
@@ -143,27 +351,95 @@ class PGOAgentROS : public PGOAgent {
   // ID of the cluster that this robot belongs to
   unsigned mClusterID;
 
+  // Protects the state of this agent against concurrent ROS callbacks and the
+  // optimization worker
+  std::mutex mAgentMutex;
+
+  // Optimization worker, woken up whenever this agent might be ready to iterate
+  std::thread mWorkerThread;
+  std::condition_variable mWorkerCondition;
+  bool mWorkerStopRequested = false;
+
+  // Callbacks received while the agent was busy, processed by the next runOnce()
+  std::mutex mDeferredCallbacksMutex;
+  std::vector<std::function<void()>> mDeferredCallbacks;
+
   // Received request to iterate with optimization in synchronous mode
   bool mSynchronousOptimizationRequested = false;
 
+  // Active neighbors whose public poses are still required before the requested
+  // iteration can start
+  std::set<unsigned> mOutstandingNeighbors;
+
+  // Robots scheduled by the latest UPDATE command that have not finished their
+  // iteration (only used by the leader with the Coloring update rule)
+  std::set<unsigned> mPendingUpdateRobots;
+  unsigned mPendingUpdateIteration = 0;
+
+  // Index of the color to update next (only used with the Coloring update rule)
+  size_t mUpdateColorIndex = 0;
+
   // Flag to publish INITIALIZE command
   bool mPublishInitializeCommandRequested = false;
 
   // Flag to attempt initialization
   bool mTryInitializeRequested = false;
 
+  // State reported by the last published status
+  std::optional<PGOAgentState> mPublishedState;
+
+  // Phases of an iteration whose latency is measured
+  enum class LatencyPhase {
+    WaitForNeighbors,  // From receiving the UPDATE command to being ready to iterate
+    Iterate,           // Local iteration (including RTR)
+    PublicPoses,       // Serialization and publication of public poses
+    Status,            // Publication of status
+    Dispatch,          // Selection and publication of the next UPDATE command
+    Count
+  };
+
+  // Latency histogram of each phase (cleared after logging at TERMINATE)
+  std::array<LatencyHistogram, (size_t)LatencyPhase::Count> mLatencyHistograms;
+
+  // Time when this robot was selected to update and started waiting for neighbors
+  std::optional<std::chrono::steady_clock::time_point> mUpdateRequestedTime;
+
   // Handle to log file
   std::ofstream mIterationLog;
 
+  // Binary log file written by a background thread (only used with binary log)
+  AsyncBinaryLogger mBinaryLog;
+
   // Number of initialization steps performed
   int mInitStepsDone;
 
-  // Total bytes of public poses received
+  // Total serialized bytes received from other robots (reset after each round)
   size_t mTotalBytesReceived;
 
+  // Total serialized bytes sent to other robots (reset after each round)
+  size_t mTotalBytesSent;
+
+  // Serialized bytes and messages exchanged per topic and peer robot since launch
+  BandwidthMonitor mBandwidthMonitor;
+
   // Elapsed time for the latest update
   double mIterationElapsedMs;
 
+  // Smoothed round trip time between publishing an UPDATE command and receiving the
+  // status of a robot that is not selected to update (only used with adaptive pacing)
+  std::optional<double> mCommandRoundTripSec;
+
+  // Latest UPDATE command published by this robot whose round trip is not measured yet
+  std::optional<ros::Time> mUpdateCommandSentTime;
+  unsigned mUpdateCommandIteration = 0;
+  std::set<unsigned> mUpdateCommandRobots;
+
+  // Time this robot last published its public poses
+  std::optional<ros::Time> mLastPublicPosesTime;
+
+  // Maximum quantization error of public poses sent since the latest logged iteration
+  double mPublicPosesQuantizationError;
+
   // Global optimization start time
   ros::Time mGlobalStartTime, mLastCommandTime;
 
@@ -175,9 +451,24 @@ class PGOAgentROS : public PGOAgent {
 
   // Data structures to enforce synchronization during iterations
   std::vector<unsigned> mTeamIterReceived;
+  std::vector<unsigned> mTeamAuxIterReceived;
   std::vector<unsigned> mTeamIterRequired;
   std::vector<bool> mTeamReceivedSharedLoopClosures;
 
+  // Sequence number of the shared loop closures received from each robot in the
+  // current round (acknowledged in the status)
+  std::map<unsigned, uint32_t> mReceivedSharedLoopClosureSequences;
+
+  // Sequence number of the latest shared loop closures published by this robot
+  uint32_t mSharedLoopClosureSequence = 0;
+
+  // Epoch of the shared loop closures received by this robot, reported in the status.
+  // Changes when the robot restarts or resets its pose graph.
+  uint64_t mSharedLoopClosureEpoch;
+
+  // Shared loop closures that each robot acknowledged (these are not sent again)
+  SharedLoopClosureTracker mSharedLoopClosureTracker;
+
   // Store if other robots are currently connected
   std::vector<bool> mTeamConnected;
 
@@ -194,9 +485,40 @@ class PGOAgentROS : public PGOAgent {
   // Store the latest measurement weights with neighbors
   std::unordered_map<EdgeID, double, HashEdgeID> mCachedEdgeWeights;
 
+  // Public poses (and auxiliary public poses) last sent to each neighbor
+  std::map<unsigned, PoseDict> mSentPublicPoses;
+  std::map<unsigned, PoseDict> mSentAuxPublicPoses;
+
+  // Number of delta public poses messages sent to each neighbor since the last full one
+  std::map<unsigned, int> mNumDeltaPublicPosesSent;
+  std::map<unsigned, int> mNumDeltaAuxPublicPosesSent;
+
+  // Measurement weights last sent to each neighbor, in edge index order
+  struct SentMeasurementWeights {
+    std::vector<EdgeID> edges;
+    std::vector<double> weights;
+    std::vector<bool> fixedWeights;
+    int numDeltas = 0;
+  };
+  std::map<unsigned, SentMeasurementWeights> mSentMeasurementWeights;
+
+  // Shared loop closures of the latest full measurement weights message from each
+  // neighbor, in edge index order
+  std::map<unsigned, std::vector<EdgeID>> mReceivedWeightEdges;
+
+  // Number of edges and nodes of the local pose graph received from the front end
+  uint64_t mPoseGraphEdgeWatermark;
+  uint64_t mPoseGraphNodeWatermark;
+
+  // False if the front end does not provide incremental pose graph queries
+  bool mPoseGraphDeltaAvailable;
+
   // Last time reset is called
   ros::Time mLastResetTime;
 
+  // Time of the latest iterate publication
+  std::optional<ros::Time> mLastIteratePublishTime;
+
   // Time this node is launched
   ros::Time mLaunchTime;
 
@@ -209,15 +531,131 @@ class PGOAgentROS : public PGOAgent {
   // Tasks to run in synchronous mode at every ROS spin
   void runOnceSynchronous();
 
+  // Return true if an update was requested and public poses from all active
+  // neighbors have been received
+  bool isReadyToIterate() const;
+
+  // Iteration number of a neighbor required before this robot can iterate
+  int requiredNeighborIteration(unsigned neighbor) const;
+
+  // Return true if the required public poses of a neighbor have been received. With
+  // acceleration, both the regular and the auxiliary poses are required.
+  bool hasRequiredNeighborPoses(unsigned neighbor) const;
+
+  // Recompute the neighbors this robot waits for. Must be called whenever an update
+  // is requested or the required iterations or active robots change.
+  void resetReadinessTracker();
+
+  // Update the readiness tracker after receiving public poses from a neighbor
+  void updateReadinessTracker(unsigned neighbor);
+
+  // Called exactly once when the last required public poses are received
+  void onReadyToIterate();
+
+  // Publish public poses if requested after the latest iteration
+  void publishRequestedPublicPoses();
+
+  // Sleep time before publishing an UPDATE command to the given robots
+  double computeUpdatePacingDelay(const std::vector<unsigned> &robot_ids) const;
+
+  // Update the round trip estimate with a status received from another robot
+  void updateCommandRoundTrip(const Status &msg);
+
+  // Publish status, iterate and log after a local iteration
+  void publishIterationResults();
+
+  // Check termination condition or notify the next robot(s) to update
+  void dispatchNextUpdate();
+
+  // Latency histogram of the given phase
+  LatencyHistogram &latencyHistogram(LatencyPhase phase) {
+    return mLatencyHistograms[(size_t)phase];
+  }
+
+  // Name of the given phase in diagnostics and logs
+  static std::string latencyPhaseToString(LatencyPhase phase);
+
+  // Publish percentiles of the latency histograms on the diagnostics topic
+  void publishLatencyDiagnostics();
+
+  // Count the serialized size of a message sent to another robot
+  template <class MsgType>
+  void countSent(const std::string &topic, int peer, const MsgType &msg) {
+    const uint32_t bytes = ros::serialization::serializationLength(msg);
+    mBandwidthMonitor.record(BandwidthMonitor::Direction::Sent, topic, peer, bytes);
+    mTotalBytesSent += bytes;
+  }
+
+  // Count the serialized size of a message received from another robot (messages
+  // published by this robot are ignored)
+  template <class MsgType>
+  void countReceived(const std::string &topic, int peer, const MsgType &msg) {
+    if (peer == (int)getID()) return;
+    const uint32_t bytes = ros::serialization::serializationLength(msg);
+    mBandwidthMonitor.record(BandwidthMonitor::Direction::Received, topic, peer, bytes);
+    mTotalBytesReceived += bytes;
+  }
+
+  // Publish bytes and message rates of each link on the diagnostics topic
+  void publishBandwidthDiagnostics();
+
+  // Topic in the namespace of the given robot on which all robots publish the messages
+  // addressed to it (only used with per-destination topics)
+  std::string destinationTopic(const std::string &topic, unsigned robot_id) const;
+
+  // Advertise the topic of each receiving robot (only used with per-destination topics)
+  template <class MsgType>
+  void advertiseDestinationTopics(const std::string &topic,
+                                  uint32_t queue_size,
+                                  std::vector<ros::Publisher> &publishers) {
+    publishers.clear();
+    for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+      publishers.push_back(
+          nh.advertise<MsgType>(destinationTopic(topic, robot_id), queue_size));
+    }
+  }
+
+  // Publisher of messages addressed to the given robot
+  const ros::Publisher &destinationPublisher(
+      const ros::Publisher &publisher,
+      const std::vector<ros::Publisher> &destination_publishers,
+      unsigned robot_id) const {
+    if (!mParamsROS.perDestinationTopics) return publisher;
+    return destination_publishers.at(robot_id);
+  }
+
+  // Write percentiles of the latency histograms to the console and log file
+  void logLatencySummary();
+
+  // Return true if runOnce() has work to do
+  bool hasPendingWork();
+
+  // Main loop of the optimization worker
+  void optimizationWorkerLoop();
+
+  // Process callbacks that were deferred while the agent was busy
+  void processDeferredCallbacks();
+
   // Tasks to run in asynchronous mode at every ROS spin
   void runOnceAsynchronous();
 
   // Request latest local pose graph
   bool requestPoseGraph();
 
+  // Query the full local pose graph from the front end
+  bool queryFullPoseGraph(pose_graph_tools_msgs::PoseGraph &pose_graph);
+
+  // Query the edges and nodes added to the local pose graph since the last query.
+  // Return false if the query failed, in which case the full pose graph should be used.
+  bool queryPoseGraphDelta(pose_graph_tools_msgs::PoseGraph &pose_graph);
+
   // Attempt to initialize optimization
   bool tryInitialize();
 
+  // Initialize in the global frame from the solution of the previous round. Return
+  // false if there is no usable previous solution.
+  bool warmStartInitialize();
+
   // Get the ID of the current cluster
   unsigned getClusterID() const;
 
@@ -249,13 +687,32 @@ class PGOAgentROS : public PGOAgent {
   // Publish command to request pose graph
   void publishRequestPoseGraphCommand();
 
-  // Publish initialize command
-  void publishInitializeCommand();
+  // Publish initialize command. Event-driven re-sends do not count as initialization
+  // attempts.
+  void publishInitializeCommand(bool count_attempt = true);
+
+  // Attempt initialization right away (only with event-driven initialization)
+  void tryInitializeOnEvent();
 
   // Publish update command
   void publishUpdateCommand();
   // Publish update command and specify next robot to update
   void publishUpdateCommand(unsigned robot_id);
+  // Publish update command and specify next robots to update concurrently
+  void publishUpdateCommand(const std::vector<unsigned> &robot_ids);
+
+  // Leader publishes TERMINATE, UPDATE_WEIGHT or UPDATE after an iteration
+  void publishNextCommand();
+
+  // Latest gradient norm reported by a robot (negative if unknown)
+  double getRobotGradientNorm(unsigned robot_id) const;
+
+  // Color the neighbor graph of active and initialized robots
+  std::vector<std::vector<unsigned>> computeUpdateColoring() const;
+
+  // Record that a robot finished the iteration scheduled by the leader, and
+  // schedule the next update when all scheduled robots have finished
+  void markUpdateFinished(unsigned robot_id, unsigned iteration);
 
   // Publish recover command
   void publishRecoverCommand();
@@ -287,23 +744,50 @@ class PGOAgentROS : public PGOAgent {
   // Check disconnected robot
   bool checkDisconnectedRobot();
 
-  // Publish trajectory
+  // Publish trajectory at full resolution, and decimated on the level of detail topics
+  // if enabled
   void storeOptimizedTrajectory();
   void publishTrajectory(const PoseArray &T);
   void publishOptimizedTrajectory();
+  bool isTrajectoryDecimationEnabled() const;
 
   // Publish trajectory estimates from the latest iteration in distributed optimization.
   // This function is mostly for visualization and debugging purpose.
   void publishIterate();
 
-  // Publish latest public poses
-  void publishPublicPoses(bool aux = false);
+  // Publish latest public poses. If delta encoding is enabled, only poses that changed
+  // since the last message are sent unless keyframe is true.
+  void publishPublicPoses(bool aux = false, bool keyframe = false);
+
+  // Return true if public poses published by the given robot should be processed
+  bool shouldProcessPublicPoses(unsigned robot_id, unsigned cluster_id) const;
+
+  // Process received public poses. The caller must hold mAgentMutex.
+  void processPublicPoses(const PublicPosesConstPtr &msg);
+  void processPublicPoses(const PackedPublicPosesConstPtr &msg);
+
+
+  // Store public poses received from a neighbor
+  void updatePublicPoses(unsigned robot_id,
+                         unsigned iteration_number,
+                         bool is_auxiliary,
+                         const PoseDict &poseDict);
 
   // Publish shared loop closures between this robot and others
   void publishPublicMeasurements();
 
-  // Publish weights for the responsible inter-robot loop closures
-  void publishMeasurementWeights();
+  // Mark shared loop closures sent to a robot up to the given sequence as acknowledged
+
+  // Publish weights for the responsible inter-robot loop closures. Only weights that
+  // changed since the last message are sent unless keyframe is true.
+  void publishMeasurementWeights(bool keyframe = false);
+
+  // Set the weight of a shared loop closure, updating the data matrices of the pose
+  // graph in place
+  bool setSharedLoopClosureWeight(const PoseID &src_id,
+                                  const PoseID &dst_id,
+                                  double weight,
+                                  bool fixed_weight);
 
   // Publish loop closures for visualization
   void storeLoopClosureMarkers();
@@ -312,6 +796,7 @@ class PGOAgentROS : public PGOAgent {
   // Store neighbor SE(d) poses in the global frame
   void storeActiveNeighborPoses();
   void setInactiveNeighborPoses();
+  void setCachedNeighborPoses();
 
   // Store edge weights
   void storeActiveEdgeWeights();
@@ -332,29 +817,57 @@ class PGOAgentROS : public PGOAgent {
 
   // ROS callbacks
   void connectivityCallback(const std_msgs::UInt16MultiArrayConstPtr &msg);
-  void liftingMatrixCallback(const MatrixMsgConstPtr &msg);
+  void liftingMatrixCallback(unsigned robot_id, const MatrixMsgConstPtr &msg);
   void anchorCallback(const PublicPosesConstPtr &msg);
   void statusCallback(const StatusConstPtr &msg);
   void commandCallback(const CommandConstPtr &msg);
   void publicPosesCallback(const PublicPosesConstPtr &msg);
+  void packedPublicPosesCallback(const PackedPublicPosesConstPtr &msg);
   void publicMeasurementsCallback(const RelativeMeasurementListConstPtr &msg);
   void measurementWeightsCallback(const RelativeMeasurementWeightsConstPtr &msg);
   void timerCallback(const ros::TimerEvent &event);
   void visualizationTimerCallback(const ros::TimerEvent &event);
 
+  // Run the task if the agent is idle, otherwise queue it for the next runOnce()
+  void runOrDeferCallback(std::function<void()> task);
+  void deferCallback(std::function<void()> task);
+
+  // Callback implementations. The caller must hold mAgentMutex.
+  void processConnectivity(const std_msgs::UInt16MultiArrayConstPtr &msg);
+  void processLiftingMatrix(unsigned robot_id, const MatrixMsgConstPtr &msg);
+  void processAnchor(const PublicPosesConstPtr &msg);
+  void processStatus(const StatusConstPtr &msg);
+  void processCommand(const CommandConstPtr &msg);
+  void processPublicMeasurements(const RelativeMeasurementListConstPtr &msg);
+  void processMeasurementWeights(const RelativeMeasurementWeightsConstPtr &msg);
+  void runTimerTasks();
+  void runVisualizationTimerTasks();
+
   // ROS publisher
   ros::Publisher mLiftingMatrixPublisher;
   ros::Publisher mAnchorPublisher;
   ros::Publisher mStatusPublisher;
   ros::Publisher mCommandPublisher;
   ros::Publisher mPublicPosesPublisher;
+  ros::Publisher mPackedPublicPosesPublisher;
   ros::Publisher mPublicMeasurementsPublisher;
   ros::Publisher mMeasurementWeightsPublisher;
+  // Publishers for each receiving robot (only used with per-destination topics)
+  std::vector<ros::Publisher> mPublicPosesDestinationPublishers;
+  std::vector<ros::Publisher> mPackedPublicPosesDestinationPublishers;
+  std::vector<ros::Publisher> mPublicMeasurementsDestinationPublishers;
+  std::vector<ros::Publisher> mMeasurementWeightsDestinationPublishers;
   ros::Publisher mPoseArrayPublisher;  // Publish optimized trajectory
   ros::Publisher mPathPublisher;       // Publish optimized trajectory
   ros::Publisher mPoseGraphPublisher;  // Publish optimized pose graph
+  // Decimated trajectory and pose graph
+  ros::Publisher mPoseArrayLodPublisher;
+  ros::Publisher mPathLodPublisher;
+  ros::Publisher mPoseGraphLodPublisher;
   ros::Publisher
       mLoopClosureMarkerPublisher;  // Publish loop closures for visualization
+  ros::Publisher mLatencyDiagnosticsPublisher;
+  ros::Publisher mBandwidthDiagnosticsPublisher;
 
   // ROS subscriber
   SubscriberVector mLiftingMatrixSubscriber;
@@ -362,6 +875,7 @@ class PGOAgentROS : public PGOAgent {
   SubscriberVector mCommandSubscriber;
   SubscriberVector mAnchorSubscriber;
   SubscriberVector mPublicPosesSubscriber;
+  SubscriberVector mPackedPublicPosesSubscriber;
   SubscriberVector mSharedLoopClosureSubscriber;
   SubscriberVector mMeasurementWeightsSubscriber;
   ros::Subscriber mConnectivitySubscriber;
@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/PoseGraph.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <cstddef>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Pose graph used by PGOAgentROS. Extends the DPGO pose graph with in-place
+ * updates of the quadratic cost matrix when the weights of shared loop closures change.
+ */
+class PoseGraphROS : public DPGO::PoseGraph {
+ public:
+  PoseGraphROS(unsigned int id, unsigned int r, unsigned int d);
+
+  /**
+   * @brief Set the weight of a shared loop closure. A shared loop closure only
+   * contributes to the diagonal block of the local pose in the quadratic matrix, so an
+   * existing quadratic matrix is updated in place instead of being rebuilt. The linear
+   * matrix and the preconditioner are cleared and rebuilt on the next iteration.
+   * @param src_id
+   * @param dst_id
+   * @param weight
+   * @param fixed_weight
+   * @return false if the shared loop closure does not exist
+   */
+  bool setSharedLoopClosureWeight(const DPGO::PoseID &src_id,
+                                  const DPGO::PoseID &dst_id,
+                                  double weight,
+                                  bool fixed_weight);
+
+  /**
+   * @brief Number of weight changes applied in place to the quadratic matrix
+   */
+  size_t numIncrementalUpdates() const { return mNumIncrementalUpdates; }
+
+  /**
+   * @brief Contribution of a shared loop closure with unit weight to the
+   * (d+1)-by-(d+1) diagonal block of the local pose in the quadratic matrix
+   * @param m shared loop closure
+   * @param robot_id ID of the local robot
+   * @return
+   */
+  static DPGO::Matrix sharedLoopClosureBlock(const DPGO::RelativeSEMeasurement &m,
+                                             unsigned int robot_id);
+
+ private:
+  size_t mNumIncrementalUpdates;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,95 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+
+#include <cstdint>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+namespace dpgo_ros {
+
+/**
+ * @brief Track which shared loop closures each neighbor acknowledged, so that they are
+ * not sent again in later rounds. Each neighbor reports the epoch of its shared loop
+ * closures, which changes when it restarts or resets completely. All acknowledgements
+ * of a neighbor are discarded when its epoch changes.
+ */
+class SharedLoopClosureTracker {
+ public:
+  /**
+   * @brief Epoch for the shared loop closures received by this robot, distinct from
+   * the epochs of earlier runs (based on the wall clock)
+   */
+  static uint64_t newEpoch();
+
+  /**
+   * @brief Check if a robot acknowledged a shared loop closure
+   * @param robot_id
+   * @param edge_id
+   * @return true if the shared loop closure does not need to be sent again
+   */
+  bool isAcknowledged(unsigned robot_id, const DPGO::EdgeID &edge_id) const;
+
+  /**
+   * @brief Record the shared loop closures sent to a robot in one message
+   * @param robot_id
+   * @param sequence sequence number of the message
+   * @param edges
+   */
+  void addPending(unsigned robot_id,
+                  uint32_t sequence,
+                  std::vector<DPGO::EdgeID> edges);
+
+  /**
+   * @brief Acknowledge the messages sent to a robot up to a sequence number. Messages
+   * are acknowledged in order, so all earlier messages were also received.
+   * @param robot_id
+   * @param sequence
+   */
+  void acknowledge(unsigned robot_id, uint32_t sequence);
+
+  /**
+   * @brief Update the epoch reported by a robot
+   * @param robot_id
+   * @param epoch
+   * @return true if the epoch changed and the acknowledgements of the robot were
+   * discarded
+   */
+  bool updateEpoch(unsigned robot_id, uint64_t epoch);
+
+  /**
+   * @brief Discard the messages that were not acknowledged (acknowledgements must
+   * arrive in the same round)
+   */
+  void clearPending();
+
+  /**
+   * @brief Discard all acknowledgements, e.g., after the pose graph is reset. The
+   * epochs of other robots are kept.
+   */
+  void clear();
+
+ private:
+  // Shared loop closures sent to a robot in one message, until it is acknowledged
+  struct PendingMessage {
+    uint32_t sequence;
+    std::vector<DPGO::EdgeID> edges;
+  };
+  std::map<unsigned, std::vector<PendingMessage>> mPending;
+
+  // Shared loop closures that each robot acknowledged in earlier rounds
+  std::map<unsigned, std::unordered_set<DPGO::EdgeID, DPGO::HashEdgeID>> mAcknowledged;
+
+  // Latest epoch reported by each robot (kept across rounds)
+  std::map<unsigned, uint64_t> mEpochs;
+};
+
+}  // namespace dpgo_ros
@@ -0,0 +1,157 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+#include <dpgo_ros/partition.h>
+#include <pose_graph_tools_msgs/PoseGraph.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Relative pose measurement read from a dataset file. Unlike
+ * RelativeSEMeasurement, this is a plain record without heap allocation, so that large
+ * datasets can be loaded quickly and written to a binary cache file as is.
+ */
+struct DatasetEdge {
+  uint64_t r1;
+  uint64_t r2;
+  uint64_t p1;
+  uint64_t p2;
+  // Unit quaternion (x, y, z, w)
+  double quaternion[4];
+  double translation[3];
+  double kappa;
+  double tau;
+  // Nonzero for odometry, i.e., measurements between consecutive poses of a robot in
+  // the original dataset. Kept after splitting, where local indices may be consecutive
+  // without odometry.
+  uint64_t odometry;
+};
+static_assert(std::is_trivially_copyable<DatasetEdge>::value,
+              "DatasetEdge is written to the binary cache as is");
+
+/**
+ * @brief Parse a 3D dataset in g2o format (EDGE_SE3:QUAT). The file is tokenized in
+ * place without going through iostreams. Measurements use global pose indices and
+ * robot ID 0. Rotation and translation weights (kappa, tau) are computed from the
+ * information matrix in the same way as DPGO::read_g2o_file.
+ * @param filename
+ * @param edges output measurements, in the order of the file
+ * @param num_poses output total number of poses (largest pose index plus one)
+ * @return false if the file cannot be read or contains an invalid line
+ */
+bool parseG2OFile(const std::string &filename,
+                  std::vector<DatasetEdge> &edges,
+                  size_t &num_poses);
+
+/**
+ * @brief Parse measurements in the CSV format written by DPGO::PGOLogger
+ * (robot_src,pose_src,robot_dst,pose_dst,qx,qy,qz,qw,tx,ty,tz,kappa,tau,...)
+ * @param filename
+ * @param edges output measurements, in the order of the file
+ * @return false if the file cannot be read or contains an invalid line
+ */
+bool parseMeasurementsFile(const std::string &filename,
+                           std::vector<DatasetEdge> &edges);
+
+/**
+ * @brief Endpoints of the measurements, as used by the partitioner
+ */
+std::vector<PoseEdge> poseEdges(const std::vector<DatasetEdge> &edges);
+
+/**
+ * @brief Split a centralized dataset between robots, same as splitDataset. Each robot
+ * receives its odometry, then its private loop closures, then the shared loop closures
+ * that start at one of its poses, all converted to local pose indices.
+ * @param edges measurements between global pose indices
+ * @param assignment robot ID and local pose index of each global pose index
+ * @param num_robots
+ * @return measurements of each robot
+ */
+std::vector<std::vector<DatasetEdge>> splitDatasetEdges(
+    const std::vector<DatasetEdge> &edges,
+    const std::vector<PoseID> &assignment,
+    unsigned num_robots);
+
+/**
+ * @brief Write a dataset measurement to ROS message, without going through a rotation
+ * matrix. The weights are written as covariance (see WeightsToCovariance).
+ */
+pose_graph_tools_msgs::PoseGraphEdge DatasetEdgeToMsg(const DatasetEdge &edge);
+
+/**
+ * @brief Convert a dataset measurement to a DPGO measurement
+ */
+RelativeSEMeasurement DatasetEdgeToMeasurement(const DatasetEdge &edge);
+
+/**
+ * @brief Key that identifies a split dataset in the binary cache. The key changes
+ * whenever the dataset file (path, size or modification time) or the partition settings
+ * change.
+ * @param filename dataset file
+ * @param num_robots
+ * @param partition_method
+ * @param partition_imbalance
+ * @return key, or an empty string if the dataset file does not exist
+ */
+std::string datasetCacheKey(const std::string &filename,
+                            unsigned num_robots,
+                            const std::string &partition_method,
+                            double partition_imbalance);
+
+/**
+ * @brief Path of the cache file of a dataset inside the cache directory
+ * @param cache_directory
+ * @param filename dataset file
+ * @param key see datasetCacheKey
+ * @return
+ */
+std::string datasetCacheFile(const std::string &cache_directory,
+                             const std::string &filename,
+                             const std::string &key);
+
+/**
+ * @brief Write the measurements of each robot to a binary cache file. The file is first
+ * written under a temporary name and then renamed, so that concurrent readers never see
+ * a partial file. The cache uses the native byte order and is not portable between
+ * machines.
+ * @param cache_file
+ * @param key see datasetCacheKey
+ * @param num_poses total number of poses of the dataset
+ * @param robot_edges measurements of each robot
+ * @return
+ */
+bool writeDatasetCache(const std::string &cache_file,
+                       const std::string &key,
+                       size_t num_poses,
+                       const std::vector<std::vector<DatasetEdge>> &robot_edges);
+
+/**
+ * @brief Read the measurements of each robot from a binary cache file. The file is
+ * memory mapped and the measurement records are copied out without parsing.
+ * @param cache_file
+ * @param key see datasetCacheKey
+ * @param num_poses output total number of poses of the dataset
+ * @param robot_edges output measurements of each robot
+ * @return false if the file does not exist, is invalid, or was written with another key
+ */
+bool readDatasetCache(const std::string &cache_file,
+                      const std::string &key,
+                      size_t &num_poses,
+                      std::vector<std::vector<DatasetEdge>> &robot_edges);
+
+}  // namespace dpgo_ros
@@ -0,0 +1,97 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#pragma once
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <utility>
+#include <vector>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+/**
+ * @brief Global pose indices (p1, p2) of the endpoints of a measurement
+ */
+typedef std::pair<size_t, size_t> PoseEdge;
+
+/**
+ * @brief Extract the endpoints of measurements between global pose indices
+ * @param measurements
+ * @return
+ */
+std::vector<PoseEdge> poseEdges(const std::vector<RelativeSEMeasurement> &measurements);
+
+/**
+ * @brief Partition the poses of a centralized pose graph into parts with balanced
+ * numbers of poses, while minimizing the number of measurements between different
+ * parts. This is a multilevel partitioner: the graph is coarsened by heavy edge
+ * matching, the coarsest graph is partitioned by greedy graph growing, and the
+ * partition is refined with boundary moves while projecting it back to the original
+ * graph. Finally, poses that are disconnected from the rest of their part are moved
+ * to a neighboring part, so that each part (robot) has a connected pose graph. The
+ * balance constraint is only violated if it cannot be restored without disconnecting
+ * a part.
+ * @param num_poses total number of poses
+ * @param edges endpoints of the measurements, in global pose indices (p1, p2)
+ * @param num_parts
+ * @param imbalance maximum relative deviation of the number of poses of each part
+ * from the average (e.g., 0.05)
+ * @return part of each pose, or an empty vector if there are fewer poses than parts
+ */
+std::vector<unsigned> partitionPoseGraph(size_t num_poses,
+                                         const std::vector<PoseEdge> &edges,
+                                         unsigned num_parts,
+                                         double imbalance);
+/** @brief Overload for measurements between global pose indices (p1, p2) */
+std::vector<unsigned> partitionPoseGraph(
+    size_t num_poses,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_parts,
+    double imbalance);
+
+/**
+ * @brief Assign poses to robots using the minimum cut partition. Local pose indices
+ * follow the order of the global pose indices.
+ * @param num_poses total number of poses
+ * @param edges endpoints of the measurements, in global pose indices (p1, p2)
+ * @param num_robots
+ * @param imbalance see partitionPoseGraph
+ * @return robot ID and local pose index of each global pose index, or an empty vector
+ * if there are fewer poses than robots
+ */
+std::vector<PoseID> minCutPoseAssignment(size_t num_poses,
+                                         const std::vector<PoseEdge> &edges,
+                                         unsigned num_robots,
+                                         double imbalance);
+/** @brief Overload for measurements between global pose indices (p1, p2) */
+std::vector<PoseID> minCutPoseAssignment(
+    size_t num_poses,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_robots,
+    double imbalance);
+
+/**
+ * @brief Count the measurements between poses assigned to different robots
+ * @param assignment robot ID and local pose index of each global pose index
+ * @param edges endpoints of the measurements, in global pose indices (p1, p2)
+ * @param num_robots
+ * @return number of measurements with an endpoint at each robot
+ */
+std::vector<size_t> computeEdgeCuts(const std::vector<PoseID> &assignment,
+                                    const std::vector<PoseEdge> &edges,
+                                    unsigned num_robots);
+/** @brief Overload for measurements between global pose indices (p1, p2) */
+std::vector<size_t> computeEdgeCuts(
+    const std::vector<PoseID> &assignment,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_robots);
+
+}  // namespace dpgo_ros
@@ -11,6 +11,7 @@
 #include <DPGO/PGOAgent.h>
 #include <DPGO/RelativeSEMeasurement.h>
 #include <dpgo_ros/MatrixMsg.h>
+#include <dpgo_ros/PackedPublicPoses.h>
 #include <dpgo_ros/PublicPoses.h>
 #include <dpgo_ros/Status.h>
 #include <geometry_msgs/PoseArray.h>
@@ -22,6 +23,8 @@
 
 #include <cassert>
 #include <fstream>
+#include <map>
+#include <set>
 #include <vector>
 
 using namespace DPGO;
@@ -78,15 +81,86 @@ geometry_msgs::Quaternion RotationToQuaternionMsg(const Matrix &R);
  */
 geometry_msgs::Point TranslationToPointMsg(const Matrix &t);
 
+/**
+Write the rotation and translation weights (kappa, tau) as the isotropic 6x6 covariance
+(translation first, row-major) with the same weights. Invalid weights are written as a
+zero covariance.
+*/
+void WeightsToCovariance(double kappa, double tau, double *covariance);
+
+/**
+Compute the rotation and translation weights (kappa, tau) from a 6x6 covariance
+(translation first, row-major), same as DPGO::read_g2o_file. Returns false and sets
+default weights if the covariance is not set.
+*/
+bool WeightsFromCovariance(const double *covariance, double &kappa, double &tau);
+
 /**
 Write a relative measurement to ROS message
 */
 PoseGraphEdge RelativeMeasurementToMsg(const RelativeSEMeasurement &m);
+void RelativeMeasurementToMsg(const RelativeSEMeasurement &m, PoseGraphEdge &msg);
 
 /**
-Read a relative measurement from ROS message
+Read a relative measurement from ROS message. The second version writes to an existing
+measurement and reuses its storage.
 */
 RelativeSEMeasurement RelativeMeasurementFromMsg(const PoseGraphEdge &msg);
+void RelativeMeasurementFromMsg(const PoseGraphEdge &msg, RelativeSEMeasurement &m);
+
+/**
+Convert all edges of a pose graph. Measurements already in the output are reused.
+*/
+void RelativeMeasurementsFromMsgs(const std::vector<PoseGraphEdge> &msgs,
+                                  std::vector<RelativeSEMeasurement> &measurements);
+
+/**
+Convert measurements to pose graph edges. Messages already in the output are reused.
+*/
+void RelativeMeasurementsToMsgs(const std::vector<RelativeSEMeasurement> &measurements,
+                                std::vector<PoseGraphEdge> &msgs);
+
+/**
+Convert an aggregate matrix T \in (SO(d) \times Rd)^n to ROS poses. Poses already in
+the output are reused.
+*/
+void TrajectoryToPoses(unsigned d,
+                       unsigned n,
+                       const Matrix &T,
+                       std::vector<geometry_msgs::Pose> &poses);
+
+/**
+Select the poses of an aggregate matrix T \in (SO(d) \times Rd)^n to publish at a lower
+level of detail. A pose is kept if it moved by more than min_distance or rotated by more
+than min_angle (radians) since the previous kept pose, and the first and last poses are
+always kept. Non-positive thresholds are ignored (all poses are kept if both are).
+*/
+std::vector<unsigned> TrajectoryKeyframes(unsigned d,
+                                          unsigned n,
+                                          const Matrix &T,
+                                          double min_distance,
+                                          double min_angle);
+
+/**
+Convert an aggregate matrix T \in (SO(d) \times Rd)^n to the PoseArray, Path and
+PoseGraph messages at once. Each pose is converted once and all messages share the same
+time stamp. The first version only converts the poses with the given keys.
+*/
+void TrajectoryToMsgs(unsigned robotID,
+                      unsigned d,
+                      unsigned n,
+                      const Matrix &T,
+                      const std::vector<unsigned> &keys,
+                      geometry_msgs::PoseArray &pose_array,
+                      nav_msgs::Path &path,
+                      pose_graph_tools_msgs::PoseGraph &pose_graph);
+void TrajectoryToMsgs(unsigned robotID,
+                      unsigned d,
+                      unsigned n,
+                      const Matrix &T,
+                      geometry_msgs::PoseArray &pose_array,
+                      nav_msgs::Path &path,
+                      pose_graph_tools_msgs::PoseGraph &pose_graph);
 
 /**
 Convert an aggregate matrix T \in (SO(d) \times Rd)^n to a ROS PoseArray message
@@ -123,10 +197,149 @@ pose_graph_tools_msgs::PoseGraph TrajectoryToPoseGraphMsg(unsigned robotID,
                                                           const Matrix &T);
 
 /**
-Compute the number of bytes of a PublicPoses message.
+Compute the serialized size in bytes of a PublicPoses message.
 */
 size_t computePublicPosesMsgSize(const PublicPoses &msg);
 
+/**
+ * @brief Write a dictionary of lifted poses to a packed public poses message. All pose
+ * blocks must have the same size, and are copied into a single contiguous buffer in
+ * column-major order (i.e., the storage order of Eigen).
+ * @param poseDict
+ * @param msg
+ */
+void PoseDictToPackedMsg(const PoseDict &poseDict, PackedPublicPoses &msg);
+
+/**
+ * @brief Read a dictionary of lifted poses from a packed public poses message. The pose
+ * IDs are assigned to the robot that published the message. Compressed values are
+ * directly decoded into the output poses.
+ * @param msg
+ * @param poseDict
+ * @return false if the message is malformed
+ */
+bool PoseDictFromPackedMsg(const PackedPublicPoses &msg, PoseDict &poseDict);
+
+/**
+ * @brief Compress the values of a packed public poses message that is currently stored
+ * in FLOAT64 encoding. With FIXED16 encoding, values are quantized using a single
+ * quantization step (scale) for the entire message. If the resulting quantization error
+ * exceeds maxError, a more precise encoding is used instead (FIXED16, then FLOAT32,
+ * then FLOAT64).
+ * @param msg
+ * @param encoding PackedPublicPoses::FLOAT32 or PackedPublicPoses::FIXED16
+ * @param maxError maximum allowed absolute error of each value
+ * @return maximum absolute quantization error of the encoded values
+ */
+double compressPackedPublicPoses(PackedPublicPoses &msg,
+                                 uint8_t encoding,
+                                 double maxError);
+
+/**
+ * @brief Select the poses that changed by more than the given tolerance (measured in
+ * Frobenius norm) with respect to a reference dictionary. Poses that do not exist in
+ * the reference dictionary are always selected.
+ * @param poseDict
+ * @param reference
+ * @param tol
+ * @return
+ */
+PoseDict filterChangedPoses(const PoseDict &poseDict,
+                            const PoseDict &reference,
+                            double tol);
+
+/**
+Compute the serialized size in bytes of a PackedPublicPoses message.
+*/
+size_t computePackedPublicPosesMsgSize(const PackedPublicPoses &msg);
+
+/**
+ * @brief Greedy (Welsh-Powell) coloring of an undirected graph. Vertices are colored
+ * in order of decreasing degree, each with the smallest color not used by its
+ * neighbors.
+ * @param adjacency map from each vertex to its neighbors (must be symmetric)
+ * @return vertices grouped by color, such that vertices with the same color are not
+ * adjacent
+ */
+std::vector<std::vector<unsigned>> greedyGraphColoring(
+    const std::map<unsigned, std::set<unsigned>> &adjacency);
+
+/**
+ * @brief Compute the weights used to select the next robot to update from the
+ * gradient norms reported by the robots. Robots with unknown (negative) gradient norm
+ * receive the largest weight. If all weights are zero, all robots receive the same
+ * weight.
+ * @param gradient_norms
+ * @return
+ */
+std::vector<double> gradientNormSelectionWeights(
+    const std::vector<double> &gradient_norms);
+
+/**
+ * @brief Measurements of a single robot after splitting a centralized dataset
+ */
+struct RobotMeasurements {
+  std::vector<RelativeSEMeasurement> odometry;
+  std::vector<RelativeSEMeasurement> privateLoopClosures;
+  std::vector<RelativeSEMeasurement> sharedLoopClosures;
+};
+
+/**
+ * @brief Assign contiguous blocks of poses to robots. Each robot receives the same
+ * number of poses, except the last robot which also receives the remaining poses.
+ * @param num_poses total number of poses in the dataset
+ * @param num_robots
+ * @return robot ID and local pose index of each global pose index, or an empty vector
+ * if there are fewer poses than robots
+ */
+std::vector<PoseID> contiguousPoseAssignment(size_t num_poses, unsigned num_robots);
+
+/**
+ * @brief Split a centralized dataset between robots. Measurements are converted to
+ * local pose indices. Odometry is identified by consecutive global pose indices, since
+ * robots may own non-contiguous blocks of poses. Shared loop closures are only assigned
+ * to the robot that owns the source pose.
+ * @param dataset measurements between global pose indices
+ * @param assignment robot ID and local pose index of each global pose index
+ * @param num_robots
+ * @return measurements of each robot
+ */
+std::vector<RobotMeasurements> splitDataset(
+    const std::vector<RelativeSEMeasurement> &dataset,
+    const std::vector<PoseID> &assignment,
+    unsigned num_robots);
+
+/**
+ * @brief Initial trajectory of a warm-started optimization round. Poses of the previous
+ * solution keep their values, and each new pose is initialized by composing a
+ * measurement with an earlier pose, preferring odometry (or copies the previous pose
+ * if there is no such measurement). Consecutive poses need not be joined by odometry.
+ * @param T_prev previous solution
+ * @param num_poses current number of poses (at least the number of previous poses)
+ * @param odometry odometry measurements of this robot
+ * @param private_loop_closures private loop closures of this robot
+ * @return
+ */
+PoseArray warmStartTrajectory(
+    const PoseArray &T_prev,
+    unsigned num_poses,
+    const std::vector<RelativeSEMeasurement> &odometry,
+    const std::vector<RelativeSEMeasurement> &private_loop_closures = {});
+
+/**
+ * @brief Extract the edges and nodes of a pose graph that were added after the given
+ * watermarks. If a watermark is larger than the number of edges or nodes (e.g., the
+ * pose graph was rebuilt), the full pose graph is returned.
+ * @param pose_graph
+ * @param edge_watermark number of edges already received
+ * @param node_watermark number of nodes already received
+ * @return
+ */
+pose_graph_tools_msgs::PoseGraph poseGraphDelta(
+    const pose_graph_tools_msgs::PoseGraph &pose_graph,
+    uint64_t edge_watermark,
+    uint64_t node_watermark);
+
 /**
  * @brief Convert a PGOAgentStatus struct to its corresponding ROS message
  * @param status
@@ -0,0 +1,241 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/AsyncBinaryLogger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace dpgo_ros {
+
+namespace {
+
+constexpr char kBinaryLogMagic[8] = {'D', 'P', 'G', 'O', 'I', 'T', 'L', 'G'};
+constexpr uint32_t kBinaryLogVersion = 2;
+
+// The writer thread wakes up at least this often to write pending records
+constexpr auto kWriterPeriod = std::chrono::milliseconds(50);
+
+struct BinaryLogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+void writeIterationLogHeader(std::ostream &os) {
+  // Robot ID, Cluster ID, global iteration number, Number of poses, total bytes
+  // received, total bytes sent, iteration time (sec), total elapsed time (sec),
+  // relative change, quantization error of public poses
+  os << "robot_id, cluster_id, num_active_robots, iteration, num_poses, "
+        "bytes_received, bytes_sent, "
+        "iter_time_sec, total_time_sec, rel_change, quantization_error \n";
+}
+
+void writeIterationLogEntry(std::ostream &os, const IterationLogEntry &entry) {
+  os << entry.robotID << ",";
+  os << entry.clusterID << ",";
+  os << entry.numActiveRobots << ",";
+  os << entry.iteration << ",";
+  os << entry.numPoses << ",";
+  os << entry.bytesReceived << ",";
+  os << entry.bytesSent << ",";
+  os << entry.iterTimeSec << ",";
+  os << entry.totalTimeSec << ",";
+  os << entry.relChange << ",";
+  os << entry.quantizationError << "\n";
+}
+
+AsyncBinaryLogger::AsyncBinaryLogger(size_t capacity)
+    : mBuffer(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2))),
+      mMask(mBuffer.size() - 1),
+      mHead(0),
+      mTail(0),
+      mFile(nullptr),
+      mNumStalls(0),
+      mStopRequested(false),
+      mFlushRequested(false),
+      mFlushedTail(0) {}
+
+AsyncBinaryLogger::~AsyncBinaryLogger() { close(); }
+
+bool AsyncBinaryLogger::open(const std::string &filename) {
+  close();
+  mFile = std::fopen(filename.c_str(), "wb");
+  if (!mFile) return false;
+  BinaryLogHeader header;
+  std::memcpy(header.magic, kBinaryLogMagic, sizeof(header.magic));
+  header.version = kBinaryLogVersion;
+  header.recordSize = sizeof(IterationLogRecord);
+  if (std::fwrite(&header, sizeof(header), 1, mFile) != 1) {
+    std::fclose(mFile);
+    mFile = nullptr;
+    return false;
+  }
+  mHead = 0;
+  mTail = 0;
+  mStopRequested = false;
+  mFlushRequested = false;
+  mFlushedTail = 0;
+  mWriterThread = std::thread(&AsyncBinaryLogger::writerLoop, this);
+  return true;
+}
+
+void AsyncBinaryLogger::close() {
+  if (!mFile) return;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopRequested = true;
+  }
+  mCondition.notify_all();
+  mWriterThread.join();
+  std::fclose(mFile);
+  mFile = nullptr;
+}
+
+void AsyncBinaryLogger::push(const IterationLogRecord &record) {
+  if (!mFile) return;
+  const size_t head = mHead.load(std::memory_order_relaxed);
+  if (head - mTail.load(std::memory_order_acquire) > mMask) {
+    // Ring buffer is full: wake up the writer thread and wait for space
+    mNumStalls++;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFlushRequested = true;
+    }
+    mCondition.notify_all();
+    while (head - mTail.load(std::memory_order_acquire) > mMask) {
+      std::this_thread::yield();
+    }
+  }
+  mBuffer[head & mMask] = record;
+  mHead.store(head + 1, std::memory_order_release);
+}
+
+void AsyncBinaryLogger::logIteration(const IterationLogEntry &entry) {
+  IterationLogRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.type = IterationLogRecord::Iteration;
+  record.textLength = 0;
+  record.iteration = entry;
+  push(record);
+}
+
+void AsyncBinaryLogger::logString(const std::string &str) {
+  size_t offset = 0;
+  do {
+    IterationLogRecord record;
+    const size_t length =
+        std::min(str.size() - offset, IterationLogRecord::kMaxTextLength);
+    std::memset(record.text, 0, sizeof(record.text));
+    std::memcpy(record.text, str.data() + offset, length);
+    offset += length;
+    record.type = offset < str.size() ? IterationLogRecord::TextContinued
+                                      : IterationLogRecord::Text;
+    record.textLength = length;
+    push(record);
+  } while (offset < str.size());
+}
+
+void AsyncBinaryLogger::flush() {
+  if (!mFile) return;
+  const size_t head = mHead.load(std::memory_order_relaxed);
+  std::unique_lock<std::mutex> lock(mMutex);
+  mFlushRequested = true;
+  mCondition.notify_all();
+  mCondition.wait(lock, [this, head] { return mFlushedTail >= head; });
+}
+
+void AsyncBinaryLogger::writerLoop() {
+  while (true) {
+    bool stop;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait_for(
+          lock, kWriterPeriod, [this] { return mStopRequested || mFlushRequested; });
+      stop = mStopRequested;
+      mFlushRequested = false;
+    }
+    // Records pushed before the stop request are written in this last batch
+    writePending();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFlushedTail = mTail.load(std::memory_order_relaxed);
+    }
+    mCondition.notify_all();
+    if (stop) break;
+  }
+}
+
+void AsyncBinaryLogger::writePending() {
+  const size_t head = mHead.load(std::memory_order_acquire);
+  size_t tail = mTail.load(std::memory_order_relaxed);
+  if (tail == head) return;
+  while (tail != head) {
+    // Write the contiguous part of the ring buffer in one call
+    const size_t begin = tail & mMask;
+    const size_t count = std::min(head - tail, mBuffer.size() - begin);
+    std::fwrite(&mBuffer[begin], sizeof(IterationLogRecord), count, mFile);
+    tail += count;
+    mTail.store(tail, std::memory_order_release);
+  }
+  std::fflush(mFile);
+}
+
+bool convertBinaryIterationLog(const std::string &binary_file,
+                               const std::string &csv_file) {
+  std::FILE *file = std::fopen(binary_file.c_str(), "rb");
+  if (!file) return false;
+  BinaryLogHeader header;
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      std::memcmp(header.magic, kBinaryLogMagic, sizeof(header.magic)) != 0 ||
+      header.version != kBinaryLogVersion ||
+      header.recordSize != sizeof(IterationLogRecord)) {
+    std::fclose(file);
+    return false;
+  }
+  std::ofstream csv(csv_file);
+  if (!csv.is_open()) {
+    std::fclose(file);
+    return false;
+  }
+  writeIterationLogHeader(csv);
+  IterationLogRecord record;
+  std::string text;
+  bool valid = true;
+  while (std::fread(&record, sizeof(record), 1, file) == 1) {
+    if (record.type == IterationLogRecord::Iteration) {
+      writeIterationLogEntry(csv, record.iteration);
+    } else if ((record.type == IterationLogRecord::Text ||
+                record.type == IterationLogRecord::TextContinued) &&
+               record.textLength <= IterationLogRecord::kMaxTextLength) {
+      text.append(record.text, record.textLength);
+      if (record.type == IterationLogRecord::Text) {
+        csv << text << "\n";
+        text.clear();
+      }
+    } else {
+      valid = false;
+      break;
+    }
+  }
+  // Keep the beginning of a text line if the log was cut before its last record
+  if (!text.empty()) csv << text << "\n";
+  std::fclose(file);
+  return valid && csv.good();
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,66 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/BandwidthMonitor.h>
+
+namespace dpgo_ros {
+
+void BandwidthMonitor::record(Direction direction,
+                              const std::string &topic,
+                              int peer,
+                              uint64_t bytes) {
+  auto &counter = mCounters[LinkKey(direction, topic, peer)];
+  counter.bytes += bytes;
+  counter.messages++;
+  if (direction == Direction::Sent) {
+    mTotalBytesSent += bytes;
+  } else {
+    mTotalBytesReceived += bytes;
+  }
+}
+
+uint64_t BandwidthMonitor::totalBytes(Direction direction) const {
+  return direction == Direction::Sent ? mTotalBytesSent : mTotalBytesReceived;
+}
+
+std::vector<BandwidthMonitor::LinkStatistics> BandwidthMonitor::statistics(
+    double time_sec) {
+  double elapsed_sec = 0;
+  if (mPreviousTimeSec) elapsed_sec = time_sec - mPreviousTimeSec.value();
+
+  std::vector<LinkStatistics> result;
+  result.reserve(mCounters.size());
+  for (const auto &it : mCounters) {
+    LinkStatistics link;
+    std::tie(link.direction, link.topic, link.peer) = it.first;
+    link.bytes = it.second.bytes;
+    link.messages = it.second.messages;
+    link.bytesPerSec = 0;
+    link.messagesPerSec = 0;
+    if (elapsed_sec > 0) {
+      Counter previous;
+      const auto previous_it = mPreviousCounters.find(it.first);
+      if (previous_it != mPreviousCounters.end()) previous = previous_it->second;
+      link.bytesPerSec = (link.bytes - previous.bytes) / elapsed_sec;
+      link.messagesPerSec = (link.messages - previous.messages) / elapsed_sec;
+    }
+    result.push_back(link);
+  }
+  mPreviousCounters = mCounters;
+  mPreviousTimeSec = time_sec;
+  return result;
+}
+
+void BandwidthMonitor::clear() {
+  mCounters.clear();
+  mPreviousCounters.clear();
+  mPreviousTimeSec.reset();
+  mTotalBytesSent = 0;
+  mTotalBytesReceived = 0;
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,66 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/LatencyHistogram.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dpgo_ros {
+
+namespace {
+
+constexpr double kMinLatencyMs = 1e-3;
+constexpr int kBucketsPerDoubling = 8;
+constexpr int kNumBuckets = 30 * kBucketsPerDoubling;
+
+size_t bucketIndex(double ms) {
+  if (!(ms > kMinLatencyMs)) return 0;
+  const int index = (int)(kBucketsPerDoubling * std::log2(ms / kMinLatencyMs));
+  return std::min(index, kNumBuckets - 1);
+}
+
+// Geometric center of a bucket
+double bucketCenterMs(size_t index) {
+  return kMinLatencyMs * std::exp2((index + 0.5) / kBucketsPerDoubling);
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : mBuckets(kNumBuckets, 0) { clear(); }
+
+void LatencyHistogram::record(double ms) {
+  mBuckets[bucketIndex(ms)]++;
+  mCount++;
+  mSumMs += ms;
+  mMinMs = std::min(mMinMs, ms);
+  mMaxMs = std::max(mMaxMs, ms);
+}
+
+void LatencyHistogram::clear() {
+  std::fill(mBuckets.begin(), mBuckets.end(), 0);
+  mCount = 0;
+  mSumMs = 0;
+  mMinMs = std::numeric_limits<double>::infinity();
+  mMaxMs = 0;
+}
+
+double LatencyHistogram::percentileMs(double q) const {
+  if (mCount == 0) return 0;
+  const double rank = std::clamp(q, 0.0, 1.0) * mCount;
+  size_t cumulative = 0;
+  for (size_t index = 0; index < mBuckets.size(); ++index) {
+    cumulative += mBuckets[index];
+    if (cumulative > 0 && cumulative >= rank) {
+      return std::clamp(bucketCenterMs(index), mMinMs, mMaxMs);
+    }
+  }
+  return mMaxMs;
+}
+
+}  // namespace dpgo_ros
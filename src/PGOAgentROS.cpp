@@ -15,6 +15,9 @@
 #include <pose_graph_tools_ros/utils.h>
 #include <tf/tf.h>
 
+#include <algorithm>
+#include <boost/bind/bind.hpp>
+#include <boost/make_shared.hpp>
 #include <map>
 #include <random>
 
@@ -24,50 +27,97 @@ namespace dpgo_ros {
 
 PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_,
                          unsigned ID,
-                         const PGOAgentROSParameters &params)
+                         const PGOAgentROSParameters &params,
+                         const ros::NodeHandle &nh_private_)
     : PGOAgent(ID, params),
       nh(nh_),
       mParamsROS(params),
       mClusterID(ID),
       mInitStepsDone(0),
       mTotalBytesReceived(0),
-      mIterationElapsedMs(0) {
+      mTotalBytesSent(0),
+      mIterationElapsedMs(0),
+      mPublicPosesQuantizationError(0),
+      mPoseGraphEdgeWatermark(0),
+      mPoseGraphNodeWatermark(0),
+      mPoseGraphDeltaAvailable(true) {
+  // Callbacks may start as soon as subscribers are created when using a
+  // multi-threaded spinner
+  std::unique_lock<std::mutex> lock(mAgentMutex);
   mTeamIterRequired.assign(mParams.numRobots, 0);
   mTeamIterReceived.assign(mParams.numRobots, 0);
+  mTeamAuxIterReceived.assign(mParams.numRobots, 0);
   mTeamReceivedSharedLoopClosures.assign(mParams.numRobots, false);
   mTeamConnected.assign(mParams.numRobots, true);
+  // Use the pose graph that supports incremental weight updates
+  mPoseGraph = std::make_shared<PoseGraphROS>(mID, r, d);
+  mSharedLoopClosureEpoch = SharedLoopClosureTracker::newEpoch();
 
   // Load robot names
   for (size_t id = 0; id < mParams.numRobots; id++) {
     std::string robot_name = "kimera" + std::to_string(id);
-    ros::param::get("~robot" + std::to_string(id) + "_name", robot_name);
+    nh_private_.getParam("robot" + std::to_string(id) + "_name", robot_name);
     mRobotNames[id] = robot_name;
   }
 
   // Add random seed parameter, default to 42
-  ros::param::get("~random_seed", mSeed);
+  nh_private_.getParam("random_seed", mSeed);
   mRng.seed(mSeed);
 
   // ROS subscriber
   for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     std::string topic_prefix = "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/";
-    mLiftingMatrixSubscriber.push_back(nh.subscribe(topic_prefix + "lifting_matrix",
-                                                    100,
-                                                    &PGOAgentROS::liftingMatrixCallback,
-                                                    this));
+    // The lifting matrix message does not identify the publishing robot
+    mLiftingMatrixSubscriber.push_back(nh.subscribe<MatrixMsg>(
+        topic_prefix + "lifting_matrix",
+        100,
+        boost::bind(&PGOAgentROS::liftingMatrixCallback,
+                    this,
+                    (unsigned)robot_id,
+                    boost::placeholders::_1)));
     mStatusSubscriber.push_back(
         nh.subscribe(topic_prefix + "status", 100, &PGOAgentROS::statusCallback, this));
     mCommandSubscriber.push_back(nh.subscribe(
         topic_prefix + "command", 100, &PGOAgentROS::commandCallback, this));
     mAnchorSubscriber.push_back(
         nh.subscribe(topic_prefix + "anchor", 100, &PGOAgentROS::anchorCallback, this));
+    // Messages addressed to all robots are always published on the shared topic
+    mSharedLoopClosureSubscriber.push_back(
+        nh.subscribe(topic_prefix + "public_measurements",
+                     100,
+                     &PGOAgentROS::publicMeasurementsCallback,
+                     this));
+    if (mParamsROS.perDestinationTopics) continue;
     mPublicPosesSubscriber.push_back(nh.subscribe(
         topic_prefix + "public_poses", 100, &PGOAgentROS::publicPosesCallback, this));
+    mPackedPublicPosesSubscriber.push_back(
+        nh.subscribe(topic_prefix + "public_poses_packed",
+                     100,
+                     &PGOAgentROS::packedPublicPosesCallback,
+                     this));
+  }
+  if (mParamsROS.perDestinationTopics) {
+    // All robots publish the messages addressed to this robot on a single topic
+    mPublicPosesSubscriber.push_back(
+        nh.subscribe(destinationTopic("public_poses", getID()),
+                     100,
+                     &PGOAgentROS::publicPosesCallback,
+                     this));
+    mPackedPublicPosesSubscriber.push_back(
+        nh.subscribe(destinationTopic("public_poses_packed", getID()),
+                     100,
+                     &PGOAgentROS::packedPublicPosesCallback,
+                     this));
     mSharedLoopClosureSubscriber.push_back(
-        nh.subscribe(topic_prefix + "public_measurements",
+        nh.subscribe(destinationTopic("public_measurements", getID()),
                      100,
                      &PGOAgentROS::publicMeasurementsCallback,
                      this));
+    mMeasurementWeightsSubscriber.push_back(
+        nh.subscribe(destinationTopic("measurement_weights", getID()),
+                     100,
+                     &PGOAgentROS::measurementWeightsCallback,
+                     this));
   }
   mConnectivitySubscriber =
       nh.subscribe("/" + mRobotNames.at(mID) + "/connected_peer_ids",
@@ -76,6 +126,7 @@ PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_,
                    this);
 
   for (size_t robot_id = 0; robot_id < getID(); ++robot_id) {
+    if (mParamsROS.perDestinationTopics) break;
     std::string topic_prefix = "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/";
     mMeasurementWeightsSubscriber.push_back(
         nh.subscribe(topic_prefix + "measurement_weights",
@@ -90,16 +141,43 @@ PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_,
   mStatusPublisher = nh.advertise<Status>("status", 1);
   mCommandPublisher = nh.advertise<Command>("command", 20);
   mPublicPosesPublisher = nh.advertise<PublicPoses>("public_poses", 20);
+  mPackedPublicPosesPublisher =
+      nh.advertise<PackedPublicPoses>("public_poses_packed", 20);
   mPublicMeasurementsPublisher =
       nh.advertise<RelativeMeasurementList>("public_measurements", 20);
   mMeasurementWeightsPublisher =
       nh.advertise<RelativeMeasurementWeights>("measurement_weights", 20);
+  if (mParamsROS.perDestinationTopics) {
+    advertiseDestinationTopics<PublicPoses>(
+        "public_poses", 20, mPublicPosesDestinationPublishers);
+    advertiseDestinationTopics<PackedPublicPoses>(
+        "public_poses_packed", 20, mPackedPublicPosesDestinationPublishers);
+    advertiseDestinationTopics<RelativeMeasurementList>(
+        "public_measurements", 20, mPublicMeasurementsDestinationPublishers);
+    advertiseDestinationTopics<RelativeMeasurementWeights>(
+        "measurement_weights", 20, mMeasurementWeightsDestinationPublishers);
+  }
   mPoseArrayPublisher = nh.advertise<geometry_msgs::PoseArray>("trajectory", 1);
   mPathPublisher = nh.advertise<nav_msgs::Path>("path", 1);
   mPoseGraphPublisher =
       nh.advertise<pose_graph_tools_msgs::PoseGraph>("optimized_pose_graph", 1);
+  if (isTrajectoryDecimationEnabled()) {
+    mPoseArrayLodPublisher =
+        nh.advertise<geometry_msgs::PoseArray>("trajectory_lod", 1);
+    mPathLodPublisher = nh.advertise<nav_msgs::Path>("path_lod", 1);
+    mPoseGraphLodPublisher =
+        nh.advertise<pose_graph_tools_msgs::PoseGraph>("optimized_pose_graph_lod", 1);
+  }
   mLoopClosureMarkerPublisher =
       nh.advertise<visualization_msgs::Marker>("loop_closures", 1);
+  if (mParamsROS.latencyDiagnostics) {
+    mLatencyDiagnosticsPublisher =
+        nh.advertise<diagnostic_msgs::DiagnosticArray>("latency_diagnostics", 1);
+  }
+  if (mParamsROS.bandwidthDiagnostics) {
+    mBandwidthDiagnosticsPublisher =
+        nh.advertise<diagnostic_msgs::DiagnosticArray>("bandwidth_diagnostics", 1);
+  }
 
   // ROS timer
   timer = nh.createTimer(ros::Duration(3.0), &PGOAgentROS::timerCallback, this);
@@ -112,7 +190,9 @@ PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_,
   // Publish lifting matrix
   for (size_t iter_ = 0; iter_ < 10; ++iter_) {
     publishNoopCommand();
+    lock.unlock();
     ros::Duration(0.5).sleep();
+    lock.lock();
   }
   mLastResetTime = ros::Time::now();
   mLaunchTime = ros::Time::now();
@@ -120,21 +200,80 @@ PGOAgentROS::PGOAgentROS(const ros::NodeHandle &nh_,
   mLastUpdateTime.reset();
 }
 
+PGOAgentROS::~PGOAgentROS() { stopOptimizationWorker(); }
+
+void PGOAgentROS::startOptimizationWorker() {
+  if (mWorkerThread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mAgentMutex);
+    mWorkerStopRequested = false;
+  }
+  mWorkerThread = std::thread(&PGOAgentROS::optimizationWorkerLoop, this);
+  ROS_INFO("Robot %u started optimization worker.", getID());
+}
+
+void PGOAgentROS::stopOptimizationWorker() {
+  if (!mWorkerThread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mAgentMutex);
+    mWorkerStopRequested = true;
+  }
+  mWorkerCondition.notify_all();
+  mWorkerThread.join();
+}
+
+void PGOAgentROS::optimizationWorkerLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mAgentMutex);
+      // Also wake up periodically to publish requested messages and check timeout
+      mWorkerCondition.wait_for(lock, std::chrono::milliseconds(10), [this] {
+        return mWorkerStopRequested || hasPendingWork();
+      });
+      if (mWorkerStopRequested) break;
+    }
+    runOnce();
+  }
+}
+
+bool PGOAgentROS::hasPendingWork() {
+  if (mPublishPublicPosesRequested || mPublishAsynchronousRequested) return true;
+  {
+    std::lock_guard<std::mutex> lock(mDeferredCallbacksMutex);
+    if (!mDeferredCallbacks.empty()) return true;
+  }
+  return isReadyToIterate();
+}
+
 void PGOAgentROS::runOnce() {
+  std::lock_guard<std::mutex> lock(mAgentMutex);
+  processDeferredCallbacks();
+
   if (mParams.asynchronous) {
     runOnceAsynchronous();
   } else {
     runOnceSynchronous();
   }
 
+  publishRequestedPublicPoses();
+
+  // Report initialization in the global frame (e.g., after receiving public poses from
+  // initialized neighbors) without waiting for the timer
+  if (mParamsROS.eventDrivenInitialization && mPublishedState != mState) {
+    publishStatus();
+  }
+
+  checkTimeout();
+  // checkDisconnectedRobot();
+}
+
+void PGOAgentROS::publishRequestedPublicPoses() {
   if (mPublishPublicPosesRequested) {
     publishPublicPoses(false);
     if (mParams.acceleration) publishPublicPoses(true);
     mPublishPublicPosesRequested = false;
+    mLastPublicPosesTime.emplace(ros::Time::now());
   }
-
-  checkTimeout();
-  // checkDisconnectedRobot();
 }
 
 void PGOAgentROS::runOnceAsynchronous() {
@@ -150,121 +289,193 @@ void PGOAgentROS::runOnceAsynchronous() {
 void PGOAgentROS::runOnceSynchronous() {
   CHECK(!mParams.asynchronous);
 
-  // Perform an optimization step
-  if (mSynchronousOptimizationRequested) {
-    // Check if ready to perform iterate
-    bool ready = true;
-    for (unsigned neighbor : mPoseGraph->activeNeighborIDs()) {
-      int requiredIter = (int)mTeamIterRequired[neighbor];
-      if (mParams.acceleration) requiredIter = (int)iteration_number() + 1;
-      requiredIter = requiredIter - mParamsROS.maxDelayedIterations;
-      if ((int)mTeamIterReceived[neighbor] < requiredIter) {
-        ready = false;
-        ROS_WARN_THROTTLE(1,
-                          "Robot %u iteration %u waits for neighbor %u "
-                          "iteration %u (last received %u).",
-                          getID(),
-                          iteration_number() + 1,
-                          neighbor,
-                          requiredIter,
-                          mTeamIterReceived[neighbor]);
-      }
+  // Perform iterate with optimization if ready
+  if (isReadyToIterate()) {
+    if (mUpdateRequestedTime) {
+      const auto elapsed =
+          std::chrono::steady_clock::now() - mUpdateRequestedTime.value();
+      latencyHistogram(LatencyPhase::WaitForNeighbors)
+          .record(std::chrono::duration<double, std::milli>(elapsed).count());
+      mUpdateRequestedTime.reset();
     }
 
-    // Perform iterate with optimization if ready
-    if (ready) {
-      // Beta feature: Apply stored neighbor poses and edge weights for inactive robots
-      // setInactiveNeighborPoses();
-      // setInactiveEdgeWeights();
-      // mPoseGraph->useInactiveNeighbors(true);
-
-      // Iterate
-      auto startTime = std::chrono::high_resolution_clock::now();
-      bool success = iterate(true);
-      auto counter = std::chrono::high_resolution_clock::now() - startTime;
-      mIterationElapsedMs =
-          (double)std::chrono::duration_cast<std::chrono::milliseconds>(counter)
-              .count();
-      mSynchronousOptimizationRequested = false;
-      if (success) {
-        mLastUpdateTime.emplace(ros::Time::now());
-        ROS_INFO(
-            "Robot %u iteration %u: success=%d, func_decr=%.1e, grad_init=%.1e, "
-            "grad_opt=%.1e.",
-            getID(),
-            iteration_number(),
-            mLocalOptResult.success,
-            mLocalOptResult.fInit - mLocalOptResult.fOpt,
-            mLocalOptResult.gradNormInit,
-            mLocalOptResult.gradNormOpt);
-      } else {
-        ROS_WARN("Robot %u iteration not successful!", getID());
-      }
+    // Beta feature: Apply stored neighbor poses and edge weights for inactive robots
+    // setInactiveNeighborPoses();
+    // setInactiveEdgeWeights();
+    // mPoseGraph->useInactiveNeighbors(true);
+
+    // Iterate
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool success;
+    {
+      ScopedTimer timer(latencyHistogram(LatencyPhase::Iterate));
+      success = iterate(true);
+    }
+    auto counter = std::chrono::high_resolution_clock::now() - startTime;
+    mIterationElapsedMs =
+        (double)std::chrono::duration_cast<std::chrono::milliseconds>(counter).count();
+    mSynchronousOptimizationRequested = false;
+    if (success) {
+      mLastUpdateTime.emplace(ros::Time::now());
+      ROS_INFO(
+          "Robot %u iteration %u: success=%d, func_decr=%.1e, grad_init=%.1e, "
+          "grad_opt=%.1e.",
+          getID(),
+          iteration_number(),
+          mLocalOptResult.success,
+          mLocalOptResult.fInit - mLocalOptResult.fOpt,
+          mLocalOptResult.gradNormInit,
+          mLocalOptResult.gradNormOpt);
+    } else {
+      ROS_WARN("Robot %u iteration not successful!", getID());
+    }
 
-      // First robot publish anchor
-      if (isLeader()) {
-        publishAnchor();
-      }
+    if (mParamsROS.pipelineUpdateCommands) {
+      // Let the next robot(s) start as early as possible, and publish the results of
+      // this iteration afterwards
+      publishRequestedPublicPoses();
+      dispatchNextUpdate();
+      publishIterationResults();
+    } else {
+      publishIterationResults();
+      // Adaptive pacing measures the delay from the public poses of this iteration
+      if (mParamsROS.adaptiveUpdatePacing) publishRequestedPublicPoses();
+      dispatchNextUpdate();
+    }
+  }
+}
 
-      // Publish status
-      publishStatus();
+void PGOAgentROS::publishIterationResults() {
+  // First robot publish anchor
+  if (isLeader()) {
+    publishAnchor();
+  }
 
-      // Publish iterate (for visualization)
-      publishIterate();
-
-      // Log local iteration
-      logIteration();
-
-      // Print information
-      if (isLeader() && mParams.verbose) {
-        ROS_INFO("Num weight updates done: %i, num inner iters: %i.",
-                 mWeightUpdateCount,
-                 mRobustOptInnerIter);
-        for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-          if (!isRobotActive(robot_id)) continue;
-          const auto &it = mTeamStatus.find(robot_id);
-          if (it != mTeamStatus.end()) {
-            const auto &robot_status = it->second;
-            ROS_INFO(
-                "Robot %zu relative change %f.", robot_id, robot_status.relativeChange);
-          } else {
-            ROS_INFO("Robot %zu status unavailable.", robot_id);
-          }
-        }
-      }
+  // Publish status
+  publishStatus();
 
-      // Check termination condition OR notify next robot to update
-      if (isLeader()) {
-        if (shouldTerminate()) {
-          publishTerminateCommand();
-        } else if (shouldUpdateMeasurementWeights()) {
-          publishUpdateWeightCommand();
-        } else {
-          publishUpdateCommand();
-        }
+  // Publish iterate (for visualization)
+  publishIterate();
+
+  // Log local iteration
+  logIteration();
+
+  // Print information
+  if (isLeader() && mParams.verbose) {
+    ROS_INFO("Num weight updates done: %i, num inner iters: %i.",
+             mWeightUpdateCount,
+             mRobustOptInnerIter);
+    for (size_t robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+      if (!isRobotActive(robot_id)) continue;
+      const auto &it = mTeamStatus.find(robot_id);
+      if (it != mTeamStatus.end()) {
+        const auto &robot_status = it->second;
+        ROS_INFO(
+            "Robot %zu relative change %f.", robot_id, robot_status.relativeChange);
       } else {
-        publishUpdateCommand();
+        ROS_INFO("Robot %zu status unavailable.", robot_id);
       }
     }
   }
 }
 
+void PGOAgentROS::dispatchNextUpdate() {
+  ScopedTimer timer(latencyHistogram(LatencyPhase::Dispatch));
+  if (mParamsROS.updateRule == PGOAgentROSParameters::UpdateRule::Coloring) {
+    // The leader schedules the next update after all scheduled robots finished
+    if (isLeader()) markUpdateFinished(getID(), iteration_number());
+  } else if (isLeader()) {
+    publishNextCommand();
+  } else {
+    publishUpdateCommand();
+  }
+}
+
+bool PGOAgentROS::isReadyToIterate() const {
+  return !mParams.asynchronous && mSynchronousOptimizationRequested &&
+         mOutstandingNeighbors.empty();
+}
+
+int PGOAgentROS::requiredNeighborIteration(unsigned neighbor) const {
+  int requiredIter = (int)mTeamIterRequired[neighbor];
+  if (mParams.acceleration) requiredIter = (int)iteration_number() + 1;
+  return requiredIter - mParamsROS.maxDelayedIterations;
+}
+
+bool PGOAgentROS::hasRequiredNeighborPoses(unsigned neighbor) const {
+  const int requiredIter = requiredNeighborIteration(neighbor);
+  if ((int)mTeamIterReceived[neighbor] < requiredIter) return false;
+  return !mParams.acceleration || (int)mTeamAuxIterReceived[neighbor] >= requiredIter;
+}
+
+void PGOAgentROS::resetReadinessTracker() {
+  mOutstandingNeighbors.clear();
+  if (mParams.asynchronous || !mSynchronousOptimizationRequested) return;
+  for (unsigned neighbor : mPoseGraph->activeNeighborIDs()) {
+    if (!hasRequiredNeighborPoses(neighbor)) mOutstandingNeighbors.insert(neighbor);
+  }
+  if (mOutstandingNeighbors.empty()) onReadyToIterate();
+}
+
+void PGOAgentROS::updateReadinessTracker(unsigned neighbor) {
+  if (!mSynchronousOptimizationRequested) return;
+  const auto it = mOutstandingNeighbors.find(neighbor);
+  if (it == mOutstandingNeighbors.end()) return;
+  if (!hasRequiredNeighborPoses(neighbor)) return;
+  mOutstandingNeighbors.erase(it);
+  if (mOutstandingNeighbors.empty()) onReadyToIterate();
+}
+
+void PGOAgentROS::onReadyToIterate() {
+  // mWorkerThread is not read here, since callbacks may run while the worker starts.
+  // A worker started later still finds this agent ready to iterate.
+  if (mParamsROS.optimizationThread) {
+    mWorkerCondition.notify_one();
+    return;
+  }
+  // Iterate immediately instead of waiting for the next spin
+  runOnceSynchronous();
+  publishRequestedPublicPoses();
+}
+
 void PGOAgentROS::reset() {
   PGOAgent::reset();
   mSynchronousOptimizationRequested = false;
+  mOutstandingNeighbors.clear();
+  mPendingUpdateRobots.clear();
+  mUpdateColorIndex = 0;
+  mUpdateCommandSentTime.reset();
+  mUpdateRequestedTime.reset();
   mTryInitializeRequested = false;
   mInitStepsDone = 0;
   mTeamIterRequired.assign(mParams.numRobots, 0);
   mTeamIterReceived.assign(mParams.numRobots, 0);
+  mTeamAuxIterReceived.assign(mParams.numRobots, 0);
   mTeamReceivedSharedLoopClosures.assign(mParams.numRobots, false);
+  mReceivedSharedLoopClosureSequences.clear();
+  mSharedLoopClosureTracker.clearPending();
   mTotalBytesReceived = 0;
+  mTotalBytesSent = 0;
   mTeamStatusMsg.clear();
+  mSentPublicPoses.clear();
+  mSentAuxPublicPoses.clear();
+  mNumDeltaPublicPosesSent.clear();
+  mNumDeltaAuxPublicPosesSent.clear();
+  mSentMeasurementWeights.clear();
+  mReceivedWeightEdges.clear();
   if (mIterationLog.is_open()) {
     mIterationLog.close();
   }
+  // Write all pending records of the binary log
+  mBinaryLog.close();
   if (mParamsROS.completeReset) {
     ROS_WARN("Reset DPGO completely.");
-    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);  // Reset pose graph
+    mPoseGraph = std::make_shared<PoseGraphROS>(mID, r, d);  // Reset pose graph
+    mSharedLoopClosureTracker.clear();
+    // Other robots must send their shared loop closures again
+    mSharedLoopClosureEpoch = SharedLoopClosureTracker::newEpoch();
+    mPoseGraphEdgeWatermark = 0;  // Request the full pose graph again
+    mPoseGraphNodeWatermark = 0;
     mCachedPoses.reset();  // Reset stored trajectory estimate
     mCachedLoopClosureMarkers.reset();
   }
@@ -273,8 +484,7 @@ void PGOAgentROS::reset() {
   mLastUpdateTime.reset();
 }
 
-bool PGOAgentROS::requestPoseGraph() {
-  // Query local pose graph
+bool PGOAgentROS::queryFullPoseGraph(pose_graph_tools_msgs::PoseGraph &pose_graph) {
   pose_graph_tools_msgs::PoseGraphQuery query;
   query.request.robot_id = getID();
   std::string service_name =
@@ -287,17 +497,61 @@ bool PGOAgentROS::requestPoseGraph() {
     ROS_ERROR_STREAM("Failed to call ROS service " << service_name);
     return false;
   }
+  pose_graph = query.response.pose_graph;
+  mPoseGraphEdgeWatermark = pose_graph.edges.size();
+  mPoseGraphNodeWatermark = pose_graph.nodes.size();
+  return true;
+}
 
-  pose_graph_tools_msgs::PoseGraph pose_graph = query.response.pose_graph;
-  if (pose_graph.edges.size() <= 1) {
+bool PGOAgentROS::queryPoseGraphDelta(pose_graph_tools_msgs::PoseGraph &pose_graph) {
+  QueryPoseGraphDelta query;
+  query.request.robot_id = getID();
+  query.request.edge_watermark = mPoseGraphEdgeWatermark;
+  query.request.node_watermark = mPoseGraphNodeWatermark;
+  std::string service_name = "/" + mRobotNames.at(getID()) +
+                             "/distributed_loop_closure/request_pose_graph_delta";
+  if (!ros::service::waitForService(service_name, ros::Duration(5.0))) {
+    ROS_WARN_STREAM("ROS service " << service_name
+                                   << " does not exist, request full pose graph.");
+    mPoseGraphDeltaAvailable = false;
+    return false;
+  }
+  if (!ros::service::call(service_name, query)) {
+    ROS_ERROR_STREAM("Failed to call ROS service " << service_name);
+    return false;
+  }
+  pose_graph = query.response.pose_graph;
+  mPoseGraphEdgeWatermark = query.response.edge_watermark;
+  mPoseGraphNodeWatermark = query.response.node_watermark;
+  return true;
+}
+
+bool PGOAgentROS::requestPoseGraph() {
+  // Query local pose graph
+  pose_graph_tools_msgs::PoseGraph pose_graph;
+  const bool incremental = mParamsROS.incrementalPoseGraph && mPoseGraphDeltaAvailable;
+  // With incremental queries, an empty response is expected if nothing changed
+  const bool has_pose_graph = incremental && mPoseGraph->numMeasurements() > 0;
+  if (incremental && queryPoseGraphDelta(pose_graph)) {
+    ROS_INFO("Received %zu new edges and %zu new nodes (watermarks %lu, %lu).",
+             pose_graph.edges.size(),
+             pose_graph.nodes.size(),
+             mPoseGraphEdgeWatermark,
+             mPoseGraphNodeWatermark);
+  } else if (!queryFullPoseGraph(pose_graph)) {
+    return false;
+  }
+
+  if (!has_pose_graph && pose_graph.edges.size() <= 1) {
     ROS_WARN("Received empty pose graph.");
     return false;
   }
 
   // Process edges
   unsigned int num_measurements_before = mPoseGraph->numMeasurements();
-  for (const auto &edge : pose_graph.edges) {
-    RelativeSEMeasurement m = RelativeMeasurementFromMsg(edge);
+  std::vector<RelativeSEMeasurement> measurements;
+  RelativeMeasurementsFromMsgs(pose_graph.edges, measurements);
+  for (const auto &m : measurements) {
     const PoseID src_id(m.r1, m.p1);
     const PoseID dst_id(m.r2, m.p2);
     if (m.r1 != getID() && m.r2 != getID()) {
@@ -335,6 +589,7 @@ bool PGOAgentROS::requestPoseGraph() {
     // Synchronize shared measurements with other robots
     mTeamReceivedSharedLoopClosures.assign(mParams.numRobots, false);
     mTeamReceivedSharedLoopClosures[getID()] = true;
+    mReceivedSharedLoopClosureSequences.clear();
 
     // In Kimera-Multi, we wait for inter-robot loops
     // from robots with smaller ID
@@ -376,6 +631,11 @@ bool PGOAgentROS::tryInitialize() {
         mPoseGraph->numPrivateLoopClosures(),
         mPoseGraph->numSharedLoopClosures());
 
+    if (mParamsROS.warmStart && warmStartInitialize()) {
+      mTryInitializeRequested = false;
+      return true;
+    }
+
     // Perform local initialization
     initialize();
 
@@ -398,6 +658,36 @@ bool PGOAgentROS::tryInitialize() {
   return ready;
 }
 
+void PGOAgentROS::tryInitializeOnEvent() {
+  if (!mParamsROS.eventDrivenInitialization || !mTryInitializeRequested) return;
+  if (tryInitialize()) publishStatus();
+}
+
+bool PGOAgentROS::warmStartInitialize() {
+  if (!mCachedPoses.has_value() || !YLift) return false;
+  const auto &TPrev = mCachedPoses.value();
+  if (TPrev.n() == 0 || TPrev.n() > num_poses()) return false;
+  ROS_INFO("Robot %u warm starts from previous solution (%u previous, %u new poses).",
+           getID(),
+           TPrev.n(),
+           num_poses() - TPrev.n());
+
+  // The previous solution is expressed in the global frame, so that the local
+  // initialization can be used as is
+  const PoseArray TInit = warmStartTrajectory(TPrev,
+                                              num_poses(),
+                                              mPoseGraph->odometry(),
+                                              mPoseGraph->privateLoopClosures());
+  initialize(&TInit);
+  initializeInGlobalFrame(Pose(d));
+  if (isLeader() && getID() != 0) {
+    initializeGlobalAnchor();
+    anchorFirstPose();
+  }
+  setCachedNeighborPoses();
+  return true;
+}
+
 bool PGOAgentROS::isRobotConnected(unsigned robot_id) const {
   if (robot_id >= mParams.numRobots) {
     return false;
@@ -438,7 +728,8 @@ void PGOAgentROS::publishLiftingMatrix() {
     ROS_WARN("Lifting matrix does not exist! ");
     return;
   }
-  MatrixMsg msg = MatrixToMsg(YLift);
+  MatrixMsgPtr msg = boost::make_shared<MatrixMsg>(MatrixToMsg(YLift));
+  countSent("lifting_matrix", BandwidthMonitor::kAllRobots, *msg);
   mLiftingMatrixPublisher.publish(msg);
 }
 
@@ -461,18 +752,91 @@ void PGOAgentROS::publishAnchor() {
     }
     T0 = globalAnchor.value().getData();
   }
-  PublicPoses msg;
-  msg.robot_id = 0;
-  msg.instance_number = instance_number();
-  msg.iteration_number = iteration_number();
-  msg.cluster_id = getClusterID();
-  msg.is_auxiliary = false;
-  msg.pose_ids.push_back(0);
-  msg.poses.push_back(MatrixToMsg(T0));
+  PublicPosesPtr msg = boost::make_shared<PublicPoses>();
+  msg->robot_id = 0;
+  msg->instance_number = instance_number();
+  msg->iteration_number = iteration_number();
+  msg->cluster_id = getClusterID();
+  msg->is_auxiliary = false;
+  msg->pose_ids.push_back(0);
+  msg->poses.push_back(MatrixToMsg(T0));
 
+  countSent("anchor", BandwidthMonitor::kAllRobots, *msg);
   mAnchorPublisher.publish(msg);
 }
 
+void PGOAgentROS::publishNextCommand() {
+  if (shouldTerminate()) {
+    publishTerminateCommand();
+  } else if (shouldUpdateMeasurementWeights()) {
+    publishUpdateWeightCommand();
+  } else {
+    publishUpdateCommand();
+  }
+}
+
+std::vector<std::vector<unsigned>> PGOAgentROS::computeUpdateColoring() const {
+  std::map<unsigned, std::set<unsigned>> adjacency;
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (isRobotActive(robot_id) && isRobotInitialized(robot_id)) {
+      adjacency[robot_id] = {};
+    }
+  }
+  for (auto &it : adjacency) {
+    const unsigned robot_id = it.first;
+    std::vector<unsigned> neighbors;
+    if (robot_id == getID()) {
+      neighbors = getNeighbors();
+    } else {
+      const auto status_it = mTeamStatusMsg.find(robot_id);
+      if (status_it == mTeamStatusMsg.end()) {
+        // Neighbors unknown: assume this robot is adjacent to all other robots
+        for (const auto &other : adjacency) {
+          if (other.first != robot_id) neighbors.push_back(other.first);
+        }
+      } else {
+        const auto &neighbor_robots = status_it->second.neighbor_robots;
+        neighbors.assign(neighbor_robots.begin(), neighbor_robots.end());
+      }
+    }
+    for (unsigned neighbor : neighbors) {
+      const auto neighbor_it = adjacency.find(neighbor);
+      if (neighbor == robot_id || neighbor_it == adjacency.end()) continue;
+      it.second.insert(neighbor);
+      neighbor_it->second.insert(robot_id);
+    }
+  }
+  return greedyGraphColoring(adjacency);
+}
+
+double PGOAgentROS::getRobotGradientNorm(unsigned robot_id) const {
+  if (robot_id == getID()) {
+    // Only available after this robot performed an update in the current round
+    if (!mLastUpdateTime.has_value()) return -1;
+    return mLocalOptResult.gradNormOpt;
+  }
+  const auto it = mTeamStatusMsg.find(robot_id);
+  if (it == mTeamStatusMsg.end()) return -1;
+  return it->second.gradient_norm;
+}
+
+void PGOAgentROS::markUpdateFinished(unsigned robot_id, unsigned iteration) {
+  if (mParamsROS.updateRule != PGOAgentROSParameters::UpdateRule::Coloring) return;
+  if (mPendingUpdateRobots.empty() || iteration < mPendingUpdateIteration) return;
+  mPendingUpdateRobots.erase(robot_id);
+  // Do not wait for robots that are no longer active
+  for (auto it = mPendingUpdateRobots.begin(); it != mPendingUpdateRobots.end();) {
+    if (!isRobotActive(*it)) {
+      it = mPendingUpdateRobots.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (!mPendingUpdateRobots.empty()) return;
+  if (!isLeader() || mState != PGOAgentState::INITIALIZED) return;
+  publishNextCommand();
+}
+
 void PGOAgentROS::publishUpdateCommand() {
   unsigned selected_robot = 0;
   switch (mParamsROS.updateRule) {
@@ -501,6 +865,44 @@ void PGOAgentROS::publishUpdateCommand() {
       selected_robot = next_robot_id;
       break;
     }
+    case PGOAgentROSParameters::UpdateRule::Greedy:
+    case PGOAgentROSParameters::UpdateRule::Importance: {
+      // Select robots based on how much they can still improve
+      std::vector<unsigned> active_robots;
+      std::vector<double> gradient_norms;
+      for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+        if (isRobotActive(robot_id) && isRobotInitialized(robot_id)) {
+          active_robots.push_back(robot_id);
+          gradient_norms.push_back(getRobotGradientNorm(robot_id));
+        }
+      }
+      if (active_robots.empty()) {
+        ROS_ERROR("[publishUpdateCommand] No robot available to update!");
+        return;
+      }
+      const auto weights = gradientNormSelectionWeights(gradient_norms);
+      if (mParamsROS.updateRule == PGOAgentROSParameters::UpdateRule::Greedy) {
+        const auto it = std::max_element(weights.begin(), weights.end());
+        selected_robot = active_robots[std::distance(weights.begin(), it)];
+      } else {
+        std::discrete_distribution<int> distribution(weights.begin(), weights.end());
+        selected_robot = active_robots[distribution(mRng)];
+      }
+      break;
+    }
+    case PGOAgentROSParameters::UpdateRule::Coloring: {
+      // Robots with the same color do not share loop closures and can update
+      // concurrently
+      const auto colors = computeUpdateColoring();
+      if (colors.empty()) {
+        ROS_ERROR("[publishUpdateCommand] No robot available to update!");
+        return;
+      }
+      mUpdateColorIndex = mUpdateColorIndex % colors.size();
+      publishUpdateCommand(colors[mUpdateColorIndex]);
+      mUpdateColorIndex++;
+      return;
+    }
   }
   if (selected_robot == getID()) {
     ROS_WARN("[publishUpdateCommand] Robot %u selects self to update next!", getID());
@@ -509,67 +911,134 @@ void PGOAgentROS::publishUpdateCommand() {
 }
 
 void PGOAgentROS::publishUpdateCommand(unsigned robot_id) {
+  publishUpdateCommand(std::vector<unsigned>{robot_id});
+}
+
+void PGOAgentROS::publishUpdateCommand(const std::vector<unsigned> &robot_ids) {
   if (mParams.asynchronous) {
     // In asynchronous mode, no need to publish update command
     // because each robot's local optimziation loop is constantly running
     return;
   }
-  if (!isRobotActive(robot_id)) {
-    ROS_ERROR("Next robot to update %u is not active!", robot_id);
-    return;
+  CHECK(!robot_ids.empty());
+  for (unsigned robot_id : robot_ids) {
+    if (!isRobotActive(robot_id)) {
+      ROS_ERROR("Next robot to update %u is not active!", robot_id);
+      return;
+    }
   }
-  if (mParamsROS.interUpdateSleepTime > 1e-3)
-    ros::Duration(mParamsROS.interUpdateSleepTime).sleep();
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.command = Command::UPDATE;
-  msg.cluster_id = getClusterID();
-  msg.publishing_robot = getID();
-  msg.executing_robot = robot_id;
-  msg.executing_iteration = iteration_number() + 1;
-  ROS_INFO_STREAM("Send UPDATE to robot " << msg.executing_robot
-                                          << " to perform iteration "
-                                          << msg.executing_iteration << ".");
+  double sleep_sec = computeUpdatePacingDelay(robot_ids);
+  if (sleep_sec > 1e-3) ros::Duration(sleep_sec).sleep();
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->command = Command::UPDATE;
+  msg->cluster_id = getClusterID();
+  msg->publishing_robot = getID();
+  msg->executing_robot = robot_ids[0];
+  msg->executing_robots.assign(robot_ids.begin(), robot_ids.end());
+  msg->executing_iteration = iteration_number() + 1;
+  if (mParamsROS.updateRule == PGOAgentROSParameters::UpdateRule::Coloring &&
+      isLeader()) {
+    // The leader also waits for itself to process this command
+    mPendingUpdateRobots = std::set<unsigned>(robot_ids.begin(), robot_ids.end());
+    mPendingUpdateRobots.insert(getID());
+    mPendingUpdateIteration = msg->executing_iteration;
+  }
+  if (mParamsROS.adaptiveUpdatePacing) {
+    // Round trip is measured with the status of robots that iterate immediately
+    mUpdateCommandSentTime.emplace(msg->header.stamp);
+    mUpdateCommandIteration = msg->executing_iteration;
+    mUpdateCommandRobots = std::set<unsigned>(robot_ids.begin(), robot_ids.end());
+  }
+  ROS_INFO_STREAM("Send UPDATE to " << robot_ids.size() << " robot(s) starting with "
+                                    << msg->executing_robot << " to perform iteration "
+                                    << msg->executing_iteration << ".");
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
 }
 
+double PGOAgentROS::computeUpdatePacingDelay(
+    const std::vector<unsigned> &robot_ids) const {
+  const double max_sleep_sec = mParamsROS.interUpdateSleepTime;
+  if (!mParamsROS.adaptiveUpdatePacing) return max_sleep_sec;
+  // Without delayed iterations, the selected robots wait for the public poses of this
+  // robot before iterating
+  if (mParamsROS.maxDelayedIterations <= 0) return 0;
+  // No need to wait if none of the selected robots uses the public poses of this robot
+  const auto neighbors = getNeighbors();
+  bool has_dependency = false;
+  for (unsigned robot_id : robot_ids) {
+    if (robot_id != getID() &&
+        std::find(neighbors.begin(), neighbors.end(), robot_id) != neighbors.end()) {
+      has_dependency = true;
+    }
+  }
+  if (!has_dependency) return 0;
+  if (!mCommandRoundTripSec.has_value() || !mLastPublicPosesTime.has_value()) {
+    return max_sleep_sec;
+  }
+  // Wait until the public poses published last are expected to be delivered
+  double elapsed_sec = (ros::Time::now() - mLastPublicPosesTime.value()).toSec();
+  double delay_sec = 0.5 * mCommandRoundTripSec.value() - elapsed_sec;
+  return std::clamp(delay_sec, 0.0, max_sleep_sec);
+}
+
+void PGOAgentROS::updateCommandRoundTrip(const Status &msg) {
+  if (!mUpdateCommandSentTime.has_value()) return;
+  if (msg.robot_id == getID() || msg.iteration_number < mUpdateCommandIteration) return;
+  // Selected robots only publish status after local optimization
+  if (mUpdateCommandRobots.find(msg.robot_id) != mUpdateCommandRobots.end()) return;
+  double round_trip_sec = (ros::Time::now() - mUpdateCommandSentTime.value()).toSec();
+  mUpdateCommandSentTime.reset();
+  if (!mCommandRoundTripSec.has_value()) {
+    mCommandRoundTripSec.emplace(round_trip_sec);
+  } else {
+    // Exponential moving average
+    mCommandRoundTripSec = 0.8 * mCommandRoundTripSec.value() + 0.2 * round_trip_sec;
+  }
+}
+
 void PGOAgentROS::publishRecoverCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::RECOVER;
-  msg.executing_iteration = iteration_number();
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::RECOVER;
+  msg->executing_iteration = iteration_number();
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
   ROS_INFO("Robot %u published RECOVER command.", getID());
 }
 
 void PGOAgentROS::publishTerminateCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::TERMINATE;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::TERMINATE;
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
   ROS_INFO("Robot %u published TERMINATE command.", getID());
 }
 
 void PGOAgentROS::publishHardTerminateCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::HARD_TERMINATE;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::HARD_TERMINATE;
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
   ROS_INFO("Robot %u published HARD TERMINATE command.", getID());
 }
 
 void PGOAgentROS::publishUpdateWeightCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::UPDATE_WEIGHT;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::UPDATE_WEIGHT;
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
   ROS_INFO("Robot %u published UPDATE_WEIGHT command (num inner iters %i).",
            getID(),
@@ -586,31 +1055,33 @@ void PGOAgentROS::publishRequestPoseGraphCommand() {
     ROS_WARN("Not enough active robots. Do not publish request pose graph command.");
     return;
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::REQUEST_POSE_GRAPH;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::REQUEST_POSE_GRAPH;
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     if (isRobotActive(robot_id)) {
-      msg.active_robots.push_back(robot_id);
+      msg->active_robots.push_back(robot_id);
     }
   }
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
   ROS_INFO("Robot %u published REQUEST_POSE_GRAPH command.", getID());
 }
 
-void PGOAgentROS::publishInitializeCommand() {
+void PGOAgentROS::publishInitializeCommand(bool count_attempt) {
   if (!isLeader()) {
     ROS_ERROR("Only leader should send INITIALIZE command!");
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::INITIALIZE;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::INITIALIZE;
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
-  mInitStepsDone++;
+  if (count_attempt) mInitStepsDone++;
   mPublishInitializeCommandRequested = false;
   ROS_INFO("Robot %u published INITIALIZE command.", getID());
 }
@@ -620,34 +1091,48 @@ void PGOAgentROS::publishActiveRobotsCommand() {
     ROS_ERROR("Only leader should publish active robots!");
     return;
   }
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::SET_ACTIVE_ROBOTS;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::SET_ACTIVE_ROBOTS;
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     if (isRobotActive(robot_id)) {
-      msg.active_robots.push_back(robot_id);
+      msg->active_robots.push_back(robot_id);
     }
   }
 
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
 }
 
 void PGOAgentROS::publishNoopCommand() {
-  Command msg;
-  msg.header.stamp = ros::Time::now();
-  msg.publishing_robot = getID();
-  msg.cluster_id = getClusterID();
-  msg.command = Command::NOOP;
+  CommandPtr msg = boost::make_shared<Command>();
+  msg->header.stamp = ros::Time::now();
+  msg->publishing_robot = getID();
+  msg->cluster_id = getClusterID();
+  msg->command = Command::NOOP;
+  countSent("command", BandwidthMonitor::kAllRobots, *msg);
   mCommandPublisher.publish(msg);
 }
 
 void PGOAgentROS::publishStatus() {
-  Status msg = statusToMsg(getStatus());
-  msg.cluster_id = getClusterID();
-  msg.header.stamp = ros::Time::now();
+  ScopedTimer timer(latencyHistogram(LatencyPhase::Status));
+  StatusPtr msg = boost::make_shared<Status>(statusToMsg(getStatus()));
+  msg->cluster_id = getClusterID();
+  for (unsigned neighbor : getNeighbors()) {
+    msg->neighbor_robots.push_back(neighbor);
+  }
+  msg->shared_loop_closure_epoch = mSharedLoopClosureEpoch;
+  for (const auto &it : mReceivedSharedLoopClosureSequences) {
+    msg->acknowledged_robots.push_back(it.first);
+    msg->acknowledged_sequences.push_back(it.second);
+  }
+  msg->gradient_norm = getRobotGradientNorm(getID());
+  msg->header.stamp = ros::Time::now();
+  countSent("status", BandwidthMonitor::kAllRobots, *msg);
   mStatusPublisher.publish(msg);
+  mPublishedState = mState;
 }
 
 void PGOAgentROS::storeOptimizedTrajectory() {
@@ -658,19 +1143,44 @@ void PGOAgentROS::storeOptimizedTrajectory() {
 }
 
 void PGOAgentROS::publishTrajectory(const PoseArray &T) {
-  // Publish as pose array
-  geometry_msgs::PoseArray pose_array =
-      TrajectoryToPoseArray(T.d(), T.n(), T.getData());
-  mPoseArrayPublisher.publish(pose_array);
-
-  // Publish as path
-  nav_msgs::Path path = TrajectoryToPath(T.d(), T.n(), T.getData());
-  mPathPublisher.publish(path);
+  // Publish as pose array, path and optimized pose graph
+  if (mPoseArrayPublisher.getNumSubscribers() > 0 ||
+      mPathPublisher.getNumSubscribers() > 0 ||
+      mPoseGraphPublisher.getNumSubscribers() > 0) {
+    geometry_msgs::PoseArray pose_array;
+    nav_msgs::Path path;
+    pose_graph_tools_msgs::PoseGraph pose_graph;
+    TrajectoryToMsgs(getID(), T.d(), T.n(), T.getData(), pose_array, path, pose_graph);
+    mPoseArrayPublisher.publish(pose_array);
+    mPathPublisher.publish(path);
+    mPoseGraphPublisher.publish(pose_graph);
+  }
+
+  // Decimated copies on separate topics
+  if (!isTrajectoryDecimationEnabled()) return;
+  if (mPoseArrayLodPublisher.getNumSubscribers() == 0 &&
+      mPathLodPublisher.getNumSubscribers() == 0 &&
+      mPoseGraphLodPublisher.getNumSubscribers() == 0) {
+    return;
+  }
+  const auto keys = TrajectoryKeyframes(T.d(),
+                                        T.n(),
+                                        T.getData(),
+                                        mParamsROS.trajectoryDecimationDistance,
+                                        mParamsROS.trajectoryDecimationAngle);
+  geometry_msgs::PoseArray pose_array;
+  nav_msgs::Path path;
+  pose_graph_tools_msgs::PoseGraph pose_graph;
+  TrajectoryToMsgs(
+      getID(), T.d(), T.n(), T.getData(), keys, pose_array, path, pose_graph);
+  mPoseArrayLodPublisher.publish(pose_array);
+  mPathLodPublisher.publish(path);
+  mPoseGraphLodPublisher.publish(pose_graph);
+}
 
-  // Publish as optimized pose graph
-  pose_graph_tools_msgs::PoseGraph pose_graph =
-      TrajectoryToPoseGraphMsg(getID(), T.d(), T.n(), T.getData());
-  mPoseGraphPublisher.publish(pose_graph);
+bool PGOAgentROS::isTrajectoryDecimationEnabled() const {
+  return mParamsROS.trajectoryDecimationDistance > 0 ||
+         mParamsROS.trajectoryDecimationAngle > 0;
 }
 
 void PGOAgentROS::publishOptimizedTrajectory() {
@@ -683,13 +1193,29 @@ void PGOAgentROS::publishIterate() {
   if (!mParamsROS.publishIterate) {
     return;
   }
+  // Check the rate limit before computing the trajectory in the global frame
+  const ros::Time now = ros::Time::now();
+  if (mParamsROS.maxTrajectoryPublishRate > 0 && mLastIteratePublishTime.has_value() &&
+      (now - mLastIteratePublishTime.value()).toSec() <
+          1.0 / mParamsROS.maxTrajectoryPublishRate) {
+    return;
+  }
   PoseArray T(dimension(), num_poses());
   if (getTrajectoryInGlobalFrame(T)) {
+    mLastIteratePublishTime = now;
     publishTrajectory(T);
   }
 }
 
-void PGOAgentROS::publishPublicPoses(bool aux) {
+void PGOAgentROS::publishPublicPoses(bool aux, bool keyframe) {
+  ScopedTimer timer(latencyHistogram(LatencyPhase::PublicPoses));
+  // Delta encoding is only used once optimization has started, so that neighbors
+  // waiting for initialization always receive all shared poses
+  bool use_delta = mParamsROS.publicPosesChangeTolerance >= 0 &&
+                   mState == PGOAgentState::INITIALIZED && iteration_number() > 0;
+  auto &sent_poses = aux ? mSentAuxPublicPoses : mSentPublicPoses;
+  auto &num_delta_sent = aux ? mNumDeltaAuxPublicPosesSent : mNumDeltaPublicPosesSent;
+
   for (unsigned neighbor : getNeighbors()) {
     PoseDict map;
     if (aux) {
@@ -699,22 +1225,70 @@ void PGOAgentROS::publishPublicPoses(bool aux) {
     }
     if (map.empty()) continue;
 
-    PublicPoses msg;
-    msg.robot_id = getID();
-    msg.cluster_id = getClusterID();
-    msg.destination_robot_id = neighbor;
-    msg.instance_number = instance_number();
-    msg.iteration_number = iteration_number();
-    msg.is_auxiliary = aux;
+    if (use_delta) {
+      auto &sent = sent_poses[neighbor];
+      auto &num_delta = num_delta_sent[neighbor];
+      if (keyframe || sent.empty() ||
+          num_delta >= mParamsROS.publicPosesKeyframeInterval) {
+        num_delta = 0;
+      } else {
+        // Only send poses that changed. The message is still published when empty
+        // so that the neighbor receives the latest iteration number.
+        map = filterChangedPoses(map, sent, mParamsROS.publicPosesChangeTolerance);
+        num_delta++;
+      }
+      for (const auto &it : map) {
+        sent.insert_or_assign(it.first, it.second);
+      }
+    }
+
+    if (mParamsROS.publicPosesFormat ==
+        PGOAgentROSParameters::PublicPosesFormat::Packed) {
+      PackedPublicPosesPtr msg = boost::make_shared<PackedPublicPoses>();
+      msg->robot_id = getID();
+      msg->cluster_id = getClusterID();
+      msg->destination_robot_id = neighbor;
+      msg->instance_number = instance_number();
+      msg->iteration_number = iteration_number();
+      msg->is_auxiliary = aux;
+      PoseDictToPackedMsg(map, *msg);
+      if (mParamsROS.publicPosesEncoding !=
+          PGOAgentROSParameters::PublicPosesEncoding::Float64) {
+        uint8_t encoding = mParamsROS.publicPosesEncoding ==
+                                   PGOAgentROSParameters::PublicPosesEncoding::Fixed16
+                               ? PackedPublicPoses::FIXED16
+                               : PackedPublicPoses::FLOAT32;
+        double error = compressPackedPublicPoses(
+            *msg, encoding, mParamsROS.publicPosesMaxQuantizationError);
+        mPublicPosesQuantizationError = std::max(mPublicPosesQuantizationError, error);
+      }
+      countSent("public_poses_packed", neighbor, *msg);
+      destinationPublisher(mPackedPublicPosesPublisher,
+                           mPackedPublicPosesDestinationPublishers,
+                           neighbor)
+          .publish(msg);
+      continue;
+    }
+
+    PublicPosesPtr msg = boost::make_shared<PublicPoses>();
+    msg->robot_id = getID();
+    msg->cluster_id = getClusterID();
+    msg->destination_robot_id = neighbor;
+    msg->instance_number = instance_number();
+    msg->iteration_number = iteration_number();
+    msg->is_auxiliary = aux;
 
     for (const auto &sharedPose : map) {
       const PoseID nID = sharedPose.first;
       const auto &matrix = sharedPose.second.getData();
       CHECK_EQ(nID.robot_id, getID());
-      msg.pose_ids.push_back(nID.frame_id);
-      msg.poses.push_back(MatrixToMsg(matrix));
+      msg->pose_ids.push_back(nID.frame_id);
+      msg->poses.push_back(MatrixToMsg(matrix));
     }
-    mPublicPosesPublisher.publish(msg);
+    countSent("public_poses", neighbor, *msg);
+    destinationPublisher(
+        mPublicPosesPublisher, mPublicPosesDestinationPublishers, neighbor)
+        .publish(msg);
   }
 }
 
@@ -724,14 +1298,11 @@ void PGOAgentROS::publishPublicMeasurements() {
     // when assuming measurements are already synched
     return;
   }
-  std::map<unsigned, RelativeMeasurementList> msg_map;
-  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
-    RelativeMeasurementList msg;
-    msg.from_robot = getID();
-    msg.from_cluster = getClusterID();
-    msg.to_robot = robot_id;
-    msg_map[robot_id] = msg;
-  }
+  // Batch the shared loop closures with each neighbor, skipping those that the
+  // neighbor acknowledged in earlier rounds
+  const uint32_t sequence = ++mSharedLoopClosureSequence;
+  std::map<unsigned, RelativeMeasurementListPtr> msg_map;
+  std::map<unsigned, std::vector<EdgeID>> edge_map;
   for (const auto &m : mPoseGraph->sharedLoopClosures()) {
     unsigned otherID = 0;
     if (m.r1 == getID()) {
@@ -739,18 +1310,54 @@ void PGOAgentROS::publishPublicMeasurements() {
     } else {
       otherID = m.r1;
     }
-    CHECK(msg_map.find(otherID) != msg_map.end());
-    const auto edge = RelativeMeasurementToMsg(m);
-    msg_map[otherID].edges.push_back(edge);
+    const EdgeID edge_id(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2));
+    if (mSharedLoopClosureTracker.isAcknowledged(otherID, edge_id)) continue;
+    auto &msg = msg_map[otherID];
+    if (!msg) {
+      msg = boost::make_shared<RelativeMeasurementList>();
+      msg->from_robot = getID();
+      msg->from_cluster = getClusterID();
+      msg->to_robot = otherID;
+      msg->sequence = sequence;
+    }
+    msg->edges.emplace_back();
+    RelativeMeasurementToMsg(m, msg->edges.back());
+    edge_map[otherID].push_back(edge_id);
+  }
+  for (const auto &it : msg_map) {
+    countSent("public_measurements", it.first, *it.second);
+    destinationPublisher(mPublicMeasurementsPublisher,
+                         mPublicMeasurementsDestinationPublishers,
+                         it.first)
+        .publish(it.second);
+    mSharedLoopClosureTracker.addPending(it.first, sequence, edge_map[it.first]);
+  }
+
+  // Other robots still wait for this robot before initialization, so notify all of
+  // them with a single message
+  RelativeMeasurementListPtr msg = boost::make_shared<RelativeMeasurementList>();
+  msg->from_robot = getID();
+  msg->from_cluster = getClusterID();
+  msg->to_robot = RelativeMeasurementList::ALL_ROBOTS;
+  msg->sequence = sequence;
+  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
+    if (robot_id != getID() && msg_map.find(robot_id) == msg_map.end()) {
+      msg->empty_robots.push_back(robot_id);
+    }
+  }
+  if (!msg->empty_robots.empty()) {
+    countSent("public_measurements", BandwidthMonitor::kAllRobots, *msg);
+    mPublicMeasurementsPublisher.publish(msg);
   }
-  for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id)
-    mPublicMeasurementsPublisher.publish(msg_map[robot_id]);
 }
 
-void PGOAgentROS::publishMeasurementWeights() {
+void PGOAgentROS::publishMeasurementWeights(bool keyframe) {
   // if (mState != PGOAgentState::INITIALIZED) return;
 
-  std::map<unsigned, RelativeMeasurementWeights> msg_map;
+  // Shared loop closures whose weights this robot is responsible for, in pose graph
+  // order. The pose graph is append-only, so the edge index of a loop closure is stable
+  // until the number of loop closures with the neighbor changes.
+  std::map<unsigned, std::vector<const RelativeSEMeasurement *>> edge_map;
   for (const auto &m : mPoseGraph->sharedLoopClosures()) {
     unsigned otherID = 0;
     if (m.r1 == getID()) {
@@ -759,26 +1366,58 @@ void PGOAgentROS::publishMeasurementWeights() {
       otherID = m.r1;
     }
     if (otherID > getID()) {
-      if (msg_map.find(otherID) == msg_map.end()) {
-        RelativeMeasurementWeights msg;
-        msg.robot_id = getID();
-        msg.cluster_id = getClusterID();
-        msg.destination_robot_id = otherID;
-        msg_map[otherID] = msg;
-      }
-      msg_map[otherID].src_robot_ids.push_back(m.r1);
-      msg_map[otherID].dst_robot_ids.push_back(m.r2);
-      msg_map[otherID].src_pose_ids.push_back(m.p1);
-      msg_map[otherID].dst_pose_ids.push_back(m.p2);
-      msg_map[otherID].weights.push_back(m.weight);
-      msg_map[otherID].fixed_weights.push_back(m.fixedWeight);
+      edge_map[otherID].push_back(&m);
     }
   }
-  for (const auto &it : msg_map) {
-    const auto &msg = it.second;
-    if (!msg.weights.empty()) {
-      mMeasurementWeightsPublisher.publish(msg);
+  const double weight_tol = std::max(mParamsROS.weightConvergenceThreshold, 0.0);
+  for (const auto &it : edge_map) {
+    const unsigned neighbor = it.first;
+    const auto &edges = it.second;
+    auto &sent = mSentMeasurementWeights[neighbor];
+    RelativeMeasurementWeightsPtr msg =
+        boost::make_shared<RelativeMeasurementWeights>();
+    msg->robot_id = getID();
+    msg->cluster_id = getClusterID();
+    msg->destination_robot_id = neighbor;
+
+    if (keyframe || sent.edges.size() != edges.size() ||
+        sent.numDeltas >= mParamsROS.publicPosesKeyframeInterval) {
+      sent.edges.clear();
+      sent.weights.clear();
+      sent.fixedWeights.clear();
+      sent.numDeltas = 0;
+      for (const auto *m : edges) {
+        msg->src_robot_ids.push_back(m->r1);
+        msg->dst_robot_ids.push_back(m->r2);
+        msg->src_pose_ids.push_back(m->p1);
+        msg->dst_pose_ids.push_back(m->p2);
+        msg->weights.push_back(m->weight);
+        msg->fixed_weights.push_back(m->fixedWeight);
+        sent.edges.emplace_back(PoseID(m->r1, m->p1), PoseID(m->r2, m->p2));
+        sent.weights.push_back(m->weight);
+        sent.fixedWeights.push_back(m->fixedWeight);
+      }
+    } else {
+      // Only send weights that changed since the last message
+      for (size_t k = 0; k < edges.size(); ++k) {
+        const auto *m = edges[k];
+        if (std::abs(m->weight - sent.weights[k]) <= weight_tol &&
+            m->fixedWeight == sent.fixedWeights[k])
+          continue;
+        msg->edge_indices.push_back(k);
+        msg->weights.push_back(m->weight);
+        msg->fixed_weights.push_back(m->fixedWeight);
+        sent.weights[k] = m->weight;
+        sent.fixedWeights[k] = m->fixedWeight;
+      }
+      if (msg->weights.empty()) continue;
+      sent.numDeltas++;
     }
+    countSent("measurement_weights", neighbor, *msg);
+    destinationPublisher(mMeasurementWeightsPublisher,
+                         mMeasurementWeightsDestinationPublishers,
+                         neighbor)
+        .publish(msg);
   }
 }
 
@@ -880,16 +1519,19 @@ void PGOAgentROS::publishLoopClosureMarkers() {
 
 bool PGOAgentROS::createIterationLog(const std::string &filename) {
   if (mIterationLog.is_open()) mIterationLog.close();
+  if (mParamsROS.binaryLog) {
+    if (!mBinaryLog.open(filename)) {
+      ROS_ERROR_STREAM("Error opening log file: " << filename);
+      return false;
+    }
+    return true;
+  }
   mIterationLog.open(filename);
   if (!mIterationLog.is_open()) {
     ROS_ERROR_STREAM("Error opening log file: " << filename);
     return false;
   }
-  // Robot ID, Cluster ID, global iteration number, Number of poses, total bytes
-  // received, iteration time (sec), total elapsed time (sec), relative change
-  mIterationLog << "robot_id, cluster_id, num_active_robots, iteration, num_poses, "
-                   "bytes_received, "
-                   "iter_time_sec, total_time_sec, rel_change \n";
+  writeIterationLogHeader(mIterationLog);
   mIterationLog.flush();
   return true;
 }
@@ -898,7 +1540,7 @@ bool PGOAgentROS::logIteration() {
   if (!mParams.logData) {
     return false;
   }
-  if (!mIterationLog.is_open()) {
+  if (!mIterationLog.is_open() && !mBinaryLog.isOpen()) {
     ROS_ERROR_STREAM("No iteration log file!");
     return false;
   }
@@ -906,18 +1548,25 @@ bool PGOAgentROS::logIteration() {
   // Compute total elapsed time since beginning of optimization
   double globalElapsedSec = (ros::Time::now() - mGlobalStartTime).toSec();
 
-  // Robot ID, Cluster ID, global iteration number, Number of poses, total bytes
-  // received, iteration time (sec), total elapsed time (sec), relative change
-  mIterationLog << getID() << ",";
-  mIterationLog << getClusterID() << ",";
-  mIterationLog << numActiveRobots() << ",";
-  mIterationLog << iteration_number() << ",";
-  mIterationLog << num_poses() << ",";
-  mIterationLog << mTotalBytesReceived << ",";
-  mIterationLog << mIterationElapsedMs / 1e3 << ",";
-  mIterationLog << globalElapsedSec << ",";
-  mIterationLog << mStatus.relativeChange << "\n";
-  mIterationLog.flush();
+  IterationLogEntry entry;
+  entry.robotID = getID();
+  entry.clusterID = getClusterID();
+  entry.numActiveRobots = numActiveRobots();
+  entry.iteration = iteration_number();
+  entry.numPoses = num_poses();
+  entry.bytesReceived = mTotalBytesReceived;
+  entry.bytesSent = mTotalBytesSent;
+  entry.iterTimeSec = mIterationElapsedMs / 1e3;
+  entry.totalTimeSec = globalElapsedSec;
+  entry.relChange = mStatus.relativeChange;
+  entry.quantizationError = mPublicPosesQuantizationError;
+  if (mBinaryLog.isOpen()) {
+    mBinaryLog.logIteration(entry);
+  } else {
+    writeIterationLogEntry(mIterationLog, entry);
+    mIterationLog.flush();
+  }
+  mPublicPosesQuantizationError = 0;
   return true;
 }
 
@@ -925,6 +1574,10 @@ bool PGOAgentROS::logString(const std::string &str) {
   if (!mParams.logData) {
     return false;
   }
+  if (mBinaryLog.isOpen()) {
+    mBinaryLog.logString(str);
+    return true;
+  }
   if (!mIterationLog.is_open()) {
     ROS_WARN_STREAM("No iteration log file!");
     return false;
@@ -934,7 +1587,122 @@ bool PGOAgentROS::logString(const std::string &str) {
   return true;
 }
 
+std::string PGOAgentROS::latencyPhaseToString(LatencyPhase phase) {
+  switch (phase) {
+    case LatencyPhase::WaitForNeighbors: {
+      return "wait_for_neighbors";
+    }
+    case LatencyPhase::Iterate: {
+      return "iterate";
+    }
+    case LatencyPhase::PublicPoses: {
+      return "public_poses";
+    }
+    case LatencyPhase::Status: {
+      return "status";
+    }
+    case LatencyPhase::Dispatch: {
+      return "dispatch";
+    }
+    default: {
+      return "";
+    }
+  }
+}
+
+void PGOAgentROS::publishLatencyDiagnostics() {
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  for (size_t i = 0; i < mLatencyHistograms.size(); ++i) {
+    const auto &histogram = mLatencyHistograms[i];
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = "dpgo_ros/" + latencyPhaseToString((LatencyPhase)i);
+    status.hardware_id = mRobotNames.at(getID());
+    auto add_value = [&status](const std::string &key, double value) {
+      diagnostic_msgs::KeyValue key_value;
+      key_value.key = key;
+      key_value.value = std::to_string(value);
+      status.values.push_back(key_value);
+    };
+    add_value("count", histogram.count());
+    add_value("mean_ms", histogram.meanMs());
+    add_value("p50_ms", histogram.percentileMs(0.5));
+    add_value("p95_ms", histogram.percentileMs(0.95));
+    add_value("p99_ms", histogram.percentileMs(0.99));
+    add_value("max_ms", histogram.maxMs());
+    msg.status.push_back(status);
+  }
+  mLatencyDiagnosticsPublisher.publish(msg);
+}
+
+std::string PGOAgentROS::destinationTopic(const std::string &topic,
+                                          unsigned robot_id) const {
+  return "/" + mRobotNames.at(robot_id) + "/dpgo_ros_node/inbox/" + topic;
+}
+
+void PGOAgentROS::publishBandwidthDiagnostics() {
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  for (const auto &link : mBandwidthMonitor.statistics(msg.header.stamp.toSec())) {
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    const std::string peer = link.peer == BandwidthMonitor::kAllRobots
+                                 ? "all"
+                                 : mRobotNames.at(link.peer);
+    status.name = "dpgo_ros/" + BandwidthMonitor::directionToString(link.direction) +
+                  "/" + link.topic + "/" + peer;
+    status.hardware_id = mRobotNames.at(getID());
+    auto add_value = [&status](const std::string &key, const std::string &value) {
+      diagnostic_msgs::KeyValue key_value;
+      key_value.key = key;
+      key_value.value = value;
+      status.values.push_back(key_value);
+    };
+    add_value("bytes", std::to_string(link.bytes));
+    add_value("messages", std::to_string(link.messages));
+    add_value("bytes_per_sec", std::to_string(link.bytesPerSec));
+    add_value("messages_per_sec", std::to_string(link.messagesPerSec));
+    msg.status.push_back(status);
+  }
+  mBandwidthDiagnosticsPublisher.publish(msg);
+}
+
+void PGOAgentROS::logLatencySummary() {
+  // Phase, number of samples, mean, p50, p95, p99, max (ms)
+  for (size_t i = 0; i < mLatencyHistograms.size(); ++i) {
+    auto &histogram = mLatencyHistograms[i];
+    if (histogram.count() == 0) continue;
+    char buffer[256];
+    snprintf(buffer,
+             sizeof(buffer),
+             "LATENCY,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f",
+             latencyPhaseToString((LatencyPhase)i).c_str(),
+             histogram.count(),
+             histogram.meanMs(),
+             histogram.percentileMs(0.5),
+             histogram.percentileMs(0.95),
+             histogram.percentileMs(0.99),
+             histogram.maxMs());
+    logString(buffer);
+    if (mParams.verbose || mParamsROS.latencyDiagnostics) {
+      ROS_INFO("Robot %u latency of %s (ms): p50=%.3f, p95=%.3f, p99=%.3f, max=%.3f.",
+               getID(),
+               latencyPhaseToString((LatencyPhase)i).c_str(),
+               histogram.percentileMs(0.5),
+               histogram.percentileMs(0.95),
+               histogram.percentileMs(0.99),
+               histogram.maxMs());
+    }
+    histogram.clear();
+  }
+}
+
 void PGOAgentROS::connectivityCallback(const std_msgs::UInt16MultiArrayConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processConnectivity(msg); });
+}
+
+void PGOAgentROS::processConnectivity(const std_msgs::UInt16MultiArrayConstPtr &msg) {
   std::set<unsigned> connected_ids(msg->data.begin(), msg->data.end());
   for (unsigned robot_id = 0; robot_id < mParams.numRobots; ++robot_id) {
     if (robot_id == getID()) {
@@ -948,14 +1716,29 @@ void PGOAgentROS::connectivityCallback(const std_msgs::UInt16MultiArrayConstPtr
   }
 }
 
-void PGOAgentROS::liftingMatrixCallback(const MatrixMsgConstPtr &msg) {
+void PGOAgentROS::liftingMatrixCallback(unsigned robot_id,
+                                        const MatrixMsgConstPtr &msg) {
+  runOrDeferCallback([this, robot_id, msg]() { processLiftingMatrix(robot_id, msg); });
+}
+
+void PGOAgentROS::processLiftingMatrix(unsigned robot_id,
+                                       const MatrixMsgConstPtr &msg) {
+  countReceived("lifting_matrix", robot_id, *msg);
   // if (mParams.verbose) {
   //   ROS_INFO("Robot %u receives lifting matrix.", getID());
   // }
+  const bool had_lifting_matrix = YLift.has_value();
   setLiftingMatrix(MatrixFromMsg(*msg));
+  if (!had_lifting_matrix) tryInitializeOnEvent();
 }
 
 void PGOAgentROS::anchorCallback(const PublicPosesConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processAnchor(msg); });
+}
+
+void PGOAgentROS::processAnchor(const PublicPosesConstPtr &msg) {
+  // The anchor is published by the leader of the cluster
+  countReceived("anchor", msg->cluster_id, *msg);
   if (msg->robot_id != 0 || msg->pose_ids[0] != 0) {
     ROS_ERROR("Received wrong pose as anchor!");
     return;
@@ -976,8 +1759,14 @@ void PGOAgentROS::anchorCallback(const PublicPosesConstPtr &msg) {
 }
 
 void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processStatus(msg); });
+}
+
+void PGOAgentROS::processStatus(const StatusConstPtr &msg) {
+  countReceived("status", msg->robot_id, *msg);
   const auto &received_msg = *msg;
   const auto &it = mTeamStatusMsg.find(msg->robot_id);
+  bool state_changed = true;
   // Ignore message with outdated timestamp
   if (it != mTeamStatusMsg.end()) {
     const auto latest_msg = it->second;
@@ -985,8 +1774,28 @@ void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
       ROS_WARN("Received outdated status from robot %u.", msg->robot_id);
       return;
     }
+    state_changed = latest_msg.state != received_msg.state;
+  }
+  // The epoch is kept across rounds, so restarts between rounds are also detected
+  if (mSharedLoopClosureTracker.updateEpoch(msg->robot_id,
+                                            msg->shared_loop_closure_epoch)) {
+    ROS_INFO("Robot %u will resend shared loop closures to robot %u.",
+             getID(),
+             msg->robot_id);
+  }
+  for (size_t k = 0; k < msg->acknowledged_robots.size(); ++k) {
+    if (msg->acknowledged_robots[k] == getID()) {
+      mSharedLoopClosureTracker.acknowledge(msg->robot_id,
+                                            msg->acknowledged_sequences.at(k));
+    }
   }
   mTeamStatusMsg[msg->robot_id] = received_msg;
+  if (mParamsROS.adaptiveUpdatePacing) updateCommandRoundTrip(received_msg);
+
+  // With the Coloring update rule, the leader waits for all scheduled robots
+  if (!mParams.asynchronous && isLeader() && msg->cluster_id == getClusterID()) {
+    markUpdateFinished(msg->robot_id, msg->iteration_number);
+  }
 
   setRobotClusterID(msg->robot_id, msg->cluster_id);
   if (msg->cluster_id == getClusterID()) {
@@ -994,6 +1803,14 @@ void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
     ;
   }
 
+  // While waiting for robots to initialize, the leader checks again as soon as a robot
+  // makes progress, instead of at the next timer callback
+  if (mParamsROS.eventDrivenInitialization && isLeader() &&
+      mPublishInitializeCommandRequested && state_changed &&
+      msg->cluster_id == getClusterID()) {
+    publishInitializeCommand(false);
+  }
+
   // Edge cases in synchronous mode
   if (!mParams.asynchronous) {
     if (isLeader() && isRobotActive(msg->robot_id)) {
@@ -1019,6 +1836,11 @@ void PGOAgentROS::statusCallback(const StatusConstPtr &msg) {
 }
 
 void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processCommand(msg); });
+}
+
+void PGOAgentROS::processCommand(const CommandConstPtr &msg) {
+  countReceived("command", msg->publishing_robot, *msg);
   if (msg->cluster_id != getClusterID()) {
     ROS_WARN_THROTTLE(1,
                       "Ignore command from wrong cluster (recv %u, expect %u).",
@@ -1054,9 +1876,11 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         auto time_since_launch = ros::Time::now() - mLaunchTime;
         int sec_since_launch = int(time_since_launch.toSec());
         std::string log_path = mParams.logDirectory + "dpgo_log_" +
-                               std::to_string(sec_since_launch) + ".csv";
+                               std::to_string(sec_since_launch) +
+                               (mParamsROS.binaryLog ? ".bin" : ".csv");
         createIterationLog(log_path);
       }
+      tryInitializeOnEvent();
       publishStatus();
       // Enter initialization round
       if (isLeader()) {
@@ -1077,6 +1901,8 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         break;
       }
       logString("TERMINATE");
+      logLatencySummary();
+      mBinaryLog.flush();
       // When running distributed GNC, fix loop closures that have converged
       if (mParams.robustCostParams.costType == RobustCostParameters::Type::GNC_TLS) {
         double residual = 0;
@@ -1213,7 +2039,12 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
         return;
       }
       // Update local record
-      mTeamIterRequired[msg->executing_robot] = msg->executing_iteration;
+      std::set<unsigned> executing_robots(msg->executing_robots.begin(),
+                                          msg->executing_robots.end());
+      executing_robots.insert(msg->executing_robot);
+      for (unsigned robot_id : executing_robots) {
+        mTeamIterRequired[robot_id] = msg->executing_iteration;
+      }
       if (msg->executing_iteration != iteration_number() + 1) {
         ROS_WARN(
             "Update iteration does not match local iteration. (received: %u, local: "
@@ -1221,16 +2052,22 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
             msg->executing_iteration,
             iteration_number() + 1);
       }
-      if (msg->executing_robot == getID()) {
+      if (executing_robots.find(getID()) != executing_robots.end()) {
         mSynchronousOptimizationRequested = true;
+        mUpdateRequestedTime.emplace(std::chrono::steady_clock::now());
         if (mParams.verbose)
           ROS_INFO(
               "Robot %u to update at iteration %u.", getID(), msg->executing_iteration);
       } else {
         // Agents that are not selected for optimization can iterate immediately
-        iterate(false);
+        {
+          ScopedTimer timer(latencyHistogram(LatencyPhase::Iterate));
+          iterate(false);
+        }
         publishStatus();
       }
+      if (isLeader()) markUpdateFinished(getID(), iteration_number());
+      resetReadinessTracker();
       break;
     }
 
@@ -1241,14 +2078,19 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       }
       mIterationNumber = msg->executing_iteration;
       mSynchronousOptimizationRequested = false;
+      // Neighbors may have missed messages; send all public poses next time
+      mSentPublicPoses.clear();
+      mSentAuxPublicPoses.clear();
       for (const auto &neighbor : getNeighbors()) {
         mTeamIterRequired[neighbor] = iteration_number();
-        mTeamIterReceived[neighbor] =
-            0;  // Force robot to wait for updated public poses from neighbors
+        // Force robot to wait for updated public poses from neighbors
+        mTeamIterReceived[neighbor] = 0;
+        mTeamAuxIterReceived[neighbor] = 0;
       }
       ROS_WARN("Robot %u received RECOVER command and reset iteration number to %u.",
                getID(),
                iteration_number());
+      resetReadinessTracker();
 
       if (isLeader()) {
         ROS_WARN("Leader %u publishes update command.", getID());
@@ -1271,6 +2113,7 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       for (const auto &neighbor : getNeighbors()) {
         mTeamIterRequired[neighbor] = iteration_number();
       }
+      resetReadinessTracker();
       publishMeasurementWeights();
       publishPublicPoses(false);
       if (mParams.acceleration) publishPublicPoses(true);
@@ -1290,6 +2133,7 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
       }
       // Update local record of currently active robots
       updateActiveRobots(msg);
+      resetReadinessTracker();
       break;
     }
 
@@ -1303,40 +2147,122 @@ void PGOAgentROS::commandCallback(const CommandConstPtr &msg) {
   }
 }
 
-void PGOAgentROS::publicPosesCallback(const PublicPosesConstPtr &msg) {
+bool PGOAgentROS::shouldProcessPublicPoses(unsigned robot_id,
+                                           unsigned cluster_id) const {
   // Discard message sent by robots in other clusters
-  if (msg->cluster_id != getClusterID()) {
-    return;
+  if (cluster_id != getClusterID()) {
+    return false;
   }
 
   std::vector<unsigned> neighbors = getNeighbors();
-  if (std::find(neighbors.begin(), neighbors.end(), msg->robot_id) == neighbors.end()) {
+  if (std::find(neighbors.begin(), neighbors.end(), robot_id) == neighbors.end()) {
     // Discard messages send by non-neighbors
+    return false;
+  }
+  return true;
+}
+
+void PGOAgentROS::updatePublicPoses(unsigned robot_id,
+                                    unsigned iteration_number,
+                                    bool is_auxiliary,
+                                    const PoseDict &poseDict) {
+  if (!is_auxiliary) {
+    updateNeighborPoses(robot_id, poseDict);
+  } else {
+    updateAuxNeighborPoses(robot_id, poseDict);
+  }
+
+  // Update local bookkeeping
+  if (!is_auxiliary) {
+    mTeamIterReceived[robot_id] = iteration_number;
+  } else {
+    mTeamAuxIterReceived[robot_id] = iteration_number;
+  }
+  updateReadinessTracker(robot_id);
+}
+
+void PGOAgentROS::publicPosesCallback(const PublicPosesConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processPublicPoses(msg); });
+}
+
+void PGOAgentROS::processPublicPoses(const PublicPosesConstPtr &msg) {
+  countReceived("public_poses", msg->robot_id, *msg);
+  if (!shouldProcessPublicPoses(msg->robot_id, msg->cluster_id)) {
     return;
   }
 
-  // Generate a random permutation of indices
   PoseDict poseDict;
   for (size_t index = 0; index < msg->pose_ids.size(); ++index) {
     const PoseID nID(msg->robot_id, msg->pose_ids.at(index));
     const auto matrix = MatrixFromMsg(msg->poses.at(index));
     poseDict.emplace(nID, matrix);
   }
-  if (!msg->is_auxiliary) {
-    updateNeighborPoses(msg->robot_id, poseDict);
-  } else {
-    updateAuxNeighborPoses(msg->robot_id, poseDict);
+  updatePublicPoses(msg->robot_id, msg->iteration_number, msg->is_auxiliary, poseDict);
+}
+
+void PGOAgentROS::packedPublicPosesCallback(const PackedPublicPosesConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processPublicPoses(msg); });
+}
+
+void PGOAgentROS::processPublicPoses(const PackedPublicPosesConstPtr &msg) {
+  countReceived("public_poses_packed", msg->robot_id, *msg);
+  if (!shouldProcessPublicPoses(msg->robot_id, msg->cluster_id)) {
+    return;
   }
 
-  // Update local bookkeeping
-  mTeamIterReceived[msg->robot_id] = msg->iteration_number;
-  mTotalBytesReceived += computePublicPosesMsgSize(*msg);
+  PoseDict poseDict;
+  if (!PoseDictFromPackedMsg(*msg, poseDict)) {
+    ROS_ERROR("Received malformed packed public poses from robot %u.", msg->robot_id);
+    return;
+  }
+  updatePublicPoses(msg->robot_id, msg->iteration_number, msg->is_auxiliary, poseDict);
+}
+
+void PGOAgentROS::runOrDeferCallback(std::function<void()> task) {
+  // Do not block the callback thread while the agent is optimizing
+  std::unique_lock<std::mutex> lock(mAgentMutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    deferCallback(std::move(task));
+    return;
+  }
+  processDeferredCallbacks();
+  task();
+}
+
+void PGOAgentROS::deferCallback(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mDeferredCallbacksMutex);
+    mDeferredCallbacks.push_back(std::move(task));
+  }
+  mWorkerCondition.notify_one();
+}
+
+void PGOAgentROS::processDeferredCallbacks() {
+  std::vector<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mDeferredCallbacksMutex);
+    tasks.swap(mDeferredCallbacks);
+  }
+  // Messages are processed in the order they are received
+  for (const auto &task : tasks) task();
 }
 
 void PGOAgentROS::publicMeasurementsCallback(
     const RelativeMeasurementListConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processPublicMeasurements(msg); });
+}
+
+void PGOAgentROS::processPublicMeasurements(
+    const RelativeMeasurementListConstPtr &msg) {
+  countReceived("public_measurements", msg->from_robot, *msg);
   // Ignore if message not addressed to this robot
-  if (msg->to_robot != getID()) {
+  if (msg->to_robot == RelativeMeasurementList::ALL_ROBOTS) {
+    const auto &empty_robots = msg->empty_robots;
+    if (std::find(empty_robots.begin(), empty_robots.end(), getID()) ==
+        empty_robots.end()) {
+      return;
+    }
+  } else if (msg->to_robot != getID()) {
     return;
   }
   // Ignore if does not have local odometry
@@ -1346,6 +2272,9 @@ void PGOAgentROS::publicMeasurementsCallback(
   // Ignore if from another cluster
   if (msg->from_cluster != getClusterID()) return;
   mTeamReceivedSharedLoopClosures[msg->from_robot] = true;
+  if (msg->to_robot != RelativeMeasurementList::ALL_ROBOTS) {
+    mReceivedSharedLoopClosureSequences[msg->from_robot] = msg->sequence;
+  }
 
   // Add inter-robot loop closures that involve this robot
   const auto num_before = mPoseGraph->numSharedLoopClosures();
@@ -1362,21 +2291,45 @@ void PGOAgentROS::publicMeasurementsCallback(
       getID(),
       msg->from_robot,
       num_after - num_before);
+  tryInitializeOnEvent();
 }
 
 void PGOAgentROS::measurementWeightsCallback(
     const RelativeMeasurementWeightsConstPtr &msg) {
+  runOrDeferCallback([this, msg]() { processMeasurementWeights(msg); });
+}
+
+void PGOAgentROS::processMeasurementWeights(
+    const RelativeMeasurementWeightsConstPtr &msg) {
+  countReceived("measurement_weights", msg->robot_id, *msg);
   // if (mState != PGOAgentState::INITIALIZED) return;
   if (msg->destination_robot_id != getID()) return;
   if (msg->cluster_id != getClusterID()) return;
-  bool weights_updated = false;
+  auto &received_edges = mReceivedWeightEdges[msg->robot_id];
+  const bool full_msg = msg->edge_indices.empty();
+  if (full_msg) {
+    received_edges.clear();
+    for (size_t k = 0; k < msg->weights.size(); ++k) {
+      received_edges.emplace_back(PoseID(msg->src_robot_ids[k], msg->src_pose_ids[k]),
+                                  PoseID(msg->dst_robot_ids[k], msg->dst_pose_ids[k]));
+    }
+  }
   for (size_t k = 0; k < msg->weights.size(); ++k) {
-    const unsigned robotSrc = msg->src_robot_ids[k];
-    const unsigned robotDst = msg->dst_robot_ids[k];
-    const unsigned poseSrc = msg->src_pose_ids[k];
-    const unsigned poseDst = msg->dst_pose_ids[k];
-    const PoseID srcID(robotSrc, poseSrc);
-    const PoseID dstID(robotDst, poseDst);
+    const size_t index = full_msg ? k : msg->edge_indices[k];
+    if (index >= received_edges.size()) {
+      ROS_WARN_THROTTLE(1,
+                        "Robot %u received weight of unknown edge %zu from robot %u.",
+                        getID(),
+                        index,
+                        msg->robot_id);
+      continue;
+    }
+    const PoseID &srcID = received_edges[index].src_pose_id;
+    const PoseID &dstID = received_edges[index].dst_pose_id;
+    const unsigned robotSrc = srcID.robot_id;
+    const unsigned robotDst = dstID.robot_id;
+    const unsigned poseSrc = srcID.frame_id;
+    const unsigned poseDst = dstID.frame_id;
     double w = msg->weights[k];
     bool fixed = msg->fixed_weights[k];
 
@@ -1391,9 +2344,12 @@ void PGOAgentROS::measurementWeightsCallback(
     }
     if (!isRobotActive(otherID)) continue;
     if (otherID < getID()) {
-      if (setMeasurementWeight(srcID, dstID, w, fixed))
-        weights_updated = true;
-      else {
+      // Weights are sent as float32, so compare with the same precision
+      const auto *m = mPoseGraph->findMeasurement(srcID, dstID);
+      if (m && static_cast<float>(m->weight) == static_cast<float>(w) &&
+          m->fixedWeight == fixed)
+        continue;
+      if (!setSharedLoopClosureWeight(srcID, dstID, w, fixed)) {
         ROS_WARN("Cannot find specified shared loop closure (%u, %u) -> (%u, %u)",
                  robotSrc,
                  poseSrc,
@@ -1402,13 +2358,22 @@ void PGOAgentROS::measurementWeightsCallback(
       }
     }
   }
-  if (weights_updated) {
-    // Need to recompute data matrices in the pose graph
-    mPoseGraph->clearDataMatrices();
-  }
+}
+
+bool PGOAgentROS::setSharedLoopClosureWeight(const PoseID &src_id,
+                                             const PoseID &dst_id,
+                                             double weight,
+                                             bool fixed_weight) {
+  // The pose graph is always constructed as a PoseGraphROS
+  const auto pose_graph = std::static_pointer_cast<PoseGraphROS>(mPoseGraph);
+  return pose_graph->setSharedLoopClosureWeight(src_id, dst_id, weight, fixed_weight);
 }
 
 void PGOAgentROS::timerCallback(const ros::TimerEvent &event) {
+  runOrDeferCallback([this]() { runTimerTasks(); });
+}
+
+void PGOAgentROS::runTimerTasks() {
   publishNoopCommand();
   publishLiftingMatrix();
   if (mPublishInitializeCommandRequested) {
@@ -1426,19 +2391,39 @@ void PGOAgentROS::timerCallback(const ros::TimerEvent &event) {
       publishRequestPoseGraphCommand();
     }
   }
+  if (mSynchronousOptimizationRequested) {
+    for (unsigned neighbor : mOutstandingNeighbors) {
+      ROS_WARN("Robot %u iteration %u waits for neighbor %u "
+               "iteration %i (last received %u, auxiliary %u).",
+               getID(),
+               iteration_number() + 1,
+               neighbor,
+               requiredNeighborIteration(neighbor),
+               mTeamIterReceived[neighbor],
+               mTeamAuxIterReceived[neighbor]);
+    }
+  }
   if (mState == PGOAgentState::INITIALIZED) {
-    publishPublicPoses(false);
-    if (mParamsROS.acceleration) publishPublicPoses(true);
-    publishMeasurementWeights();
+    // Periodically send all public poses in case a delta message was lost
+    publishPublicPoses(false, true);
+    if (mParamsROS.acceleration) publishPublicPoses(true, true);
+    // Periodically send all weights in case a message was lost
+    publishMeasurementWeights(true);
     if (isLeader()) {
       publishAnchor();
       publishActiveRobotsCommand();
     }
   }
   publishStatus();
+  if (mParamsROS.latencyDiagnostics) publishLatencyDiagnostics();
+  if (mParamsROS.bandwidthDiagnostics) publishBandwidthDiagnostics();
 }
 
 void PGOAgentROS::visualizationTimerCallback(const ros::TimerEvent &event) {
+  runOrDeferCallback([this]() { runVisualizationTimerTasks(); });
+}
+
+void PGOAgentROS::runVisualizationTimerTasks() {
   publishOptimizedTrajectory();
   publishLoopClosureMarkers();
 }
@@ -1480,6 +2465,19 @@ void PGOAgentROS::setInactiveNeighborPoses() {
   ROS_INFO("Set %i inactive neighbor poses.", num_poses_initialized);
 }
 
+void PGOAgentROS::setCachedNeighborPoses() {
+  int num_poses_initialized = 0;
+  for (const auto &it : mCachedNeighborPoses) {
+    const auto &pose_id = it.first;
+    if (!mPoseGraph->requireNeighborPose(pose_id)) continue;
+    LiftedPose Xi(r, d);
+    Xi.setData(YLift.value() * it.second.getData());
+    neighborPoseDict[pose_id] = Xi;
+    num_poses_initialized++;
+  }
+  ROS_INFO("Set %i neighbor poses from previous solution.", num_poses_initialized);
+}
+
 void PGOAgentROS::storeActiveEdgeWeights() {
   int num_edges_stored = 0;
   for (const RelativeSEMeasurement *m : mPoseGraph->activeLoopClosures()) {
@@ -0,0 +1,63 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/PGOAgentROS.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <memory>
+
+namespace dpgo_ros {
+
+/**
+This nodelet runs a single PGO Agent inside a nodelet manager. Loading all agents into
+the same manager allows them to exchange messages without serialization.
+*/
+class PGOAgentROSNodelet : public nodelet::Nodelet {
+ private:
+  void onInit() override {
+    if (!(params = loadPGOAgentROSParameters(getPrivateNodeHandle(), ID))) {
+      NODELET_ERROR("Failed to load parameters of PGOAgentROS nodelet.");
+      return;
+    }
+    NODELET_INFO_STREAM("Initializing PGOAgent " << ID << " with params: \n"
+                                                 << params.value());
+
+    // Construction of the agent blocks for a few seconds, so it is deferred to the
+    // callback queue of this nodelet. This prevents the manager from loading the
+    // agents one after another.
+    initTimer = getNodeHandle().createTimer(
+        ros::Duration(0.01), &PGOAgentROSNodelet::initTimerCallback, this, true);
+  }
+
+  void initTimerCallback(const ros::TimerEvent &event) {
+    if (params->optimizationThread) {
+      // Callbacks of this agent run concurrently on the worker threads of the manager
+      agent = std::make_unique<PGOAgentROS>(
+          getMTNodeHandle(), ID, params.value(), getPrivateNodeHandle());
+      agent->startOptimizationWorker();
+      return;
+    }
+    agent = std::make_unique<PGOAgentROS>(
+        getNodeHandle(), ID, params.value(), getPrivateNodeHandle());
+    // Same rate as the loop of the standalone node
+    runTimer = getNodeHandle().createTimer(
+        ros::Duration(0.01), &PGOAgentROSNodelet::runTimerCallback, this);
+  }
+
+  void runTimerCallback(const ros::TimerEvent &event) { agent->runOnce(); }
+
+  unsigned ID = 0;
+  std::optional<PGOAgentROSParameters> params;
+  std::unique_ptr<PGOAgentROS> agent;
+  ros::Timer initTimer;
+  ros::Timer runTimer;
+};
+
+}  // namespace dpgo_ros
+
+PLUGINLIB_EXPORT_CLASS(dpgo_ros::PGOAgentROSNodelet, nodelet::Nodelet)
@@ -0,0 +1,331 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/PGOAgentROS.h>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+std::optional<PGOAgentROSParameters> loadPGOAgentROSParameters(
+    const ros::NodeHandle &nh_private, unsigned &ID) {
+  /**
+  ###########################################
+  Read unique ID of this agent
+  ###########################################
+  */
+  int agent_id = -1;
+  nh_private.getParam("agent_id", agent_id);
+  if (agent_id < 0) {
+    ROS_ERROR_STREAM("Negative agent id! ");
+    return std::nullopt;
+  }
+
+  /**
+  ###########################################
+  Load required options
+  ###########################################
+  */
+  int d = -1;
+  int r = -1;
+  int num_robots = 0;
+  if (!nh_private.getParam("num_robots", num_robots)) {
+    ROS_ERROR("Failed to get number of robots!");
+    return std::nullopt;
+  }
+  if (num_robots <= 0) {
+    ROS_ERROR_STREAM("Number of robots must be positive!");
+    return std::nullopt;
+  }
+  if (agent_id >= num_robots) {
+    ROS_ERROR_STREAM("ID greater than number of robots!");
+    return std::nullopt;
+  }
+  if (!nh_private.getParam("dimension", d)) {
+    ROS_ERROR("Failed to get dimension!");
+    return std::nullopt;
+  }
+  if (!nh_private.getParam("relaxation_rank", r)) {
+    ROS_ERROR("Failed to get relaxation rank!");
+    return std::nullopt;
+  }
+  if (d != 3) {
+    ROS_ERROR_STREAM("Dimension must be 3!");
+    return std::nullopt;
+  }
+  if (r < d) {
+    ROS_ERROR_STREAM("Relaxation rank cannot be smaller than dimension!");
+    return std::nullopt;
+  }
+
+  ID = (unsigned)agent_id;
+  PGOAgentROSParameters params(d, r, num_robots);
+
+  /**
+  ###########################################
+  Load optional options
+  ###########################################
+  */
+  // Run in asynchronous mode
+  nh_private.getParam("asynchronous", params.asynchronous);
+
+  if (!params.asynchronous) {
+    // Synchronous mode
+    // Use Riemannian trust-region solver
+    params.localOptimizationParams.method = ROptParameters::ROptMethod::RTR;
+  } else {
+    // Asynchronous mode
+    ROS_WARN("Running asynchronous mode.");
+    // Use gradient descent in asynchronous mode
+    params.localOptimizationParams.method = ROptParameters::ROptMethod::RGD;
+    // Frequency of optimization loop in asynchronous mode
+    nh_private.getParam("asynchronous_rate", params.asynchronousOptimizationRate);
+  }
+
+  // Local Riemannian optimization options
+  nh_private.getParam("RGD_stepsize", params.localOptimizationParams.RGD_stepsize);
+  nh_private.getParam("RGD_use_preconditioner",
+                      params.localOptimizationParams.RGD_use_preconditioner);
+  nh_private.getParam("RTR_iterations", params.localOptimizationParams.RTR_iterations);
+  nh_private.getParam("RTR_tCG_iterations",
+                      params.localOptimizationParams.RTR_tCG_iterations);
+  nh_private.getParam("RTR_gradnorm_tol", params.localOptimizationParams.gradnorm_tol);
+
+  // Local initialization
+  std::string initMethodName;
+  if (nh_private.getParam("local_initialization_method", initMethodName)) {
+    if (initMethodName == "Odometry") {
+      params.localInitializationMethod = InitializationMethod::Odometry;
+    } else if (initMethodName == "Chordal") {
+      params.localInitializationMethod = InitializationMethod::Chordal;
+    } else if (initMethodName == "GNC_TLS") {
+      params.localInitializationMethod = InitializationMethod::GNC_TLS;
+    } else {
+      ROS_ERROR_STREAM("Invalid local initialization method: " << initMethodName);
+    }
+  }
+
+  // Cross-robot initialization
+  nh_private.getParam("multirobot_initialization", params.multirobotInitialization);
+  if (!params.multirobotInitialization) {
+    ROS_WARN("DPGO cross-robot initialization is OFF.");
+  }
+
+  // Nesterov acceleration parameters
+  nh_private.getParam("acceleration", params.acceleration);
+  int restart_interval_int;
+  if (nh_private.getParam("restart_interval", restart_interval_int)) {
+    params.restartInterval = (unsigned)restart_interval_int;
+  }
+
+  // Maximum delayed iterations
+  nh_private.getParam("max_delayed_iterations", params.maxDelayedIterations);
+
+  // Inter update sleep time
+  nh_private.getParam("inter_update_sleep_time", params.interUpdateSleepTime);
+  nh_private.getParam("adaptive_update_pacing", params.adaptiveUpdatePacing);
+  nh_private.getParam("pipeline_update_commands", params.pipelineUpdateCommands);
+
+  // Delta encoding of public poses
+  nh_private.getParam("public_poses_change_tolerance",
+                      params.publicPosesChangeTolerance);
+  nh_private.getParam("public_poses_keyframe_interval",
+                      params.publicPosesKeyframeInterval);
+
+  // Run local optimization on a dedicated worker thread
+  nh_private.getParam("optimization_thread", params.optimizationThread);
+
+  // Publish messages addressed to a single robot on a topic for each receiving robot
+  nh_private.getParam("per_destination_topics", params.perDestinationTopics);
+
+  // Publish latency histograms of each phase on the diagnostics topic
+  nh_private.getParam("latency_diagnostics", params.latencyDiagnostics);
+
+  // Publish bytes and message rates per topic and peer robot
+  nh_private.getParam("bandwidth_diagnostics", params.bandwidthDiagnostics);
+
+  // Write the iteration log in binary from a background thread
+  nh_private.getParam("binary_log", params.binaryLog);
+
+  // Threshold for determining measurement weight convergence
+  nh_private.getParam("weight_convergence_threshold",
+                      params.weightConvergenceThreshold);
+
+  // Timeout threshold for considering a robot disconnected
+  nh_private.getParam("timeout_threshold", params.timeoutThreshold);
+
+  // Stopping condition in terms of relative change
+  nh_private.getParam("relative_change_tolerance", params.relChangeTol);
+
+  // Verbose flag
+  nh_private.getParam("verbose", params.verbose);
+
+  // Publish iterate during optimization
+  nh_private.getParam("publish_iterate", params.publishIterate);
+
+  // Publish loop closures as ROS markers for visualization
+  nh_private.getParam("visualize_loop_closures", params.visualizeLoopClosures);
+
+  // Level of detail of the published trajectory
+  nh_private.getParam("trajectory_decimation_distance",
+                      params.trajectoryDecimationDistance);
+  nh_private.getParam("trajectory_decimation_angle", params.trajectoryDecimationAngle);
+  nh_private.getParam("max_trajectory_publish_rate", params.maxTrajectoryPublishRate);
+
+  // Completely reset dpgo after each distributed optimization round
+  nh_private.getParam("complete_reset", params.completeReset);
+
+  // Try to recover and resume optimization after disconnection
+  nh_private.getParam("enable_recovery", params.enableRecovery);
+
+  // Synchronize shared measurements between robots before each optimization round
+  nh_private.getParam("synchronize_measurements", params.synchronizeMeasurements);
+
+  // Advance distributed initialization on message arrival instead of the timer
+  nh_private.getParam("event_driven_initialization",
+                      params.eventDrivenInitialization);
+
+  // Start each optimization round from the previous solution
+  nh_private.getParam("warm_start", params.warmStart);
+
+  // Only request new edges and nodes of the local pose graph
+  nh_private.getParam("incremental_pose_graph", params.incrementalPoseGraph);
+
+  // Maximum multi-robot initialization attempts
+  nh_private.getParam("max_distributed_init_steps", params.maxDistributedInitSteps);
+
+  // Logging
+  params.logData = nh_private.getParam("log_output_path", params.logDirectory);
+  if (params.logDirectory.empty()) {
+    params.logData = false;
+  }
+
+  // Robust cost function
+  std::string costName;
+  if (nh_private.getParam("robust_cost_type", costName)) {
+    if (costName == "L2") {
+      params.robustCostParams.costType = RobustCostParameters::Type::L2;
+    } else if (costName == "L1") {
+      params.robustCostParams.costType = RobustCostParameters::Type::L1;
+    } else if (costName == "Huber") {
+      params.robustCostParams.costType = RobustCostParameters::Type::Huber;
+    } else if (costName == "TLS") {
+      params.robustCostParams.costType = RobustCostParameters::Type::TLS;
+    } else if (costName == "GM") {
+      params.robustCostParams.costType = RobustCostParameters::Type::GM;
+    } else if (costName == "GNC_TLS") {
+      params.robustCostParams.costType = RobustCostParameters::Type::GNC_TLS;
+    } else {
+      ROS_ERROR_STREAM("Unknown robust cost type: " << costName);
+      return std::nullopt;
+    }
+  }
+
+  // GNC parameters
+  bool gnc_use_quantile = false;
+  nh_private.getParam("GNC_use_probability", gnc_use_quantile);
+  if (gnc_use_quantile) {
+    double gnc_quantile = 0.9;
+    nh_private.getParam("GNC_quantile", gnc_quantile);
+    double gnc_barc = RobustCost::computeErrorThresholdAtQuantile(gnc_quantile, 3);
+    params.robustCostParams.GNCBarc = gnc_barc;
+    ROS_INFO("PGOAgentROS: set GNC confidence quantile at %f (barc %f).",
+             gnc_quantile,
+             gnc_barc);
+  } else {
+    double gnc_barc = 5.0;
+    nh_private.getParam("GNC_barc", gnc_barc);
+    params.robustCostParams.GNCBarc = gnc_barc;
+    ROS_INFO("PGOAgentROS: set GNC barc at %f.", gnc_barc);
+  }
+  nh_private.getParam("GNC_mu_step", params.robustCostParams.GNCMuStep);
+  nh_private.getParam("GNC_init_mu", params.robustCostParams.GNCInitMu);
+  nh_private.getParam("robust_opt_num_weight_updates",
+                      params.robustOptNumWeightUpdates);
+  nh_private.getParam("robust_opt_num_resets", params.robustOptNumResets);
+  nh_private.getParam("robust_opt_min_convergence_ratio",
+                      params.robustOptMinConvergenceRatio);
+  int robust_opt_inner_iters_per_robot = 10;
+  nh_private.getParam("robust_opt_inner_iters_per_robot",
+                      robust_opt_inner_iters_per_robot);
+  params.robustOptInnerIters = num_robots * robust_opt_inner_iters_per_robot;
+  int robust_init_min_inliers;
+  if (nh_private.getParam("robust_init_min_inliers", robust_init_min_inliers)) {
+    params.robustInitMinInliers = (unsigned)robust_init_min_inliers;
+  }
+
+  // Maximum number of iterations
+  int max_iters_int;
+  if (nh_private.getParam("max_iteration_number", max_iters_int))
+    params.maxNumIters = (unsigned)max_iters_int;
+  // For robust optimization, we set the number of iterations based on the number of GNC
+  // iterations
+  if (costName != "L2") {
+    max_iters_int =
+        (params.robustOptNumWeightUpdates + 1) * params.robustOptInnerIters - 2;
+    max_iters_int = std::max(max_iters_int, 0);
+    params.maxNumIters = (unsigned)max_iters_int;
+  }
+
+  // Update rule
+  std::string update_rule_str;
+  if (nh_private.getParam("update_rule", update_rule_str)) {
+    if (update_rule_str == "Uniform") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::Uniform;
+    } else if (update_rule_str == "RoundRobin") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::RoundRobin;
+    } else if (update_rule_str == "Coloring") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::Coloring;
+    } else if (update_rule_str == "Greedy") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::Greedy;
+    } else if (update_rule_str == "Importance") {
+      params.updateRule = PGOAgentROSParameters::UpdateRule::Importance;
+    } else {
+      ROS_ERROR_STREAM("Unknown update rule: " << update_rule_str);
+      return std::nullopt;
+    }
+  }
+
+  // Public poses message format
+  std::string public_poses_format_str;
+  if (nh_private.getParam("public_poses_format", public_poses_format_str)) {
+    if (public_poses_format_str == "Matrix") {
+      params.publicPosesFormat =
+          PGOAgentROSParameters::PublicPosesFormat::Matrix;
+    } else if (public_poses_format_str == "Packed") {
+      params.publicPosesFormat =
+          PGOAgentROSParameters::PublicPosesFormat::Packed;
+    } else {
+      ROS_ERROR_STREAM("Unknown public poses format: " << public_poses_format_str);
+      return std::nullopt;
+    }
+  }
+
+  // Public poses encoding (only used by the Packed format)
+  std::string public_poses_encoding_str;
+  if (nh_private.getParam("public_poses_encoding", public_poses_encoding_str)) {
+    if (public_poses_encoding_str == "Float64") {
+      params.publicPosesEncoding =
+          PGOAgentROSParameters::PublicPosesEncoding::Float64;
+    } else if (public_poses_encoding_str == "Float32") {
+      params.publicPosesEncoding =
+          PGOAgentROSParameters::PublicPosesEncoding::Float32;
+    } else if (public_poses_encoding_str == "Fixed16") {
+      params.publicPosesEncoding =
+          PGOAgentROSParameters::PublicPosesEncoding::Fixed16;
+    } else {
+      ROS_ERROR_STREAM("Unknown public poses encoding: " << public_poses_encoding_str);
+      return std::nullopt;
+    }
+  }
+  nh_private.getParam("public_poses_max_quantization_error",
+                      params.publicPosesMaxQuantizationError);
+
+  return params;
+}
+
+}  // namespace dpgo_ros
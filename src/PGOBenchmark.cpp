@@ -0,0 +1,640 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <dpgo_ros/Command.h>
+#include <dpgo_ros/MatrixMsg.h>
+#include <dpgo_ros/PackedPublicPoses.h>
+#include <dpgo_ros/PoseGraphROS.h>
+#include <dpgo_ros/PublicPoses.h>
+#include <dpgo_ros/Status.h>
+#include <dpgo_ros/dataset.h>
+#include <dpgo_ros/partition.h>
+#include <dpgo_ros/utils.h>
+#include <ros/serialization.h>
+
+#include <boost/shared_array.hpp>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace DPGO;
+using namespace dpgo_ros;
+
+namespace {
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double secondsSince(const Clock::time_point &start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+In-memory replacement of the ROS transport. Messages are serialized and deserialized
+exactly as they would be sent between nodes, so that the benchmark includes the cost
+of message passing and can report the number of bytes exchanged.
+*/
+class MessageBus {
+ public:
+  template <typename M>
+  M transmit(const M &msg) {
+    namespace ser = ros::serialization;
+    uint32_t length = ser::serializationLength(msg);
+    boost::shared_array<uint8_t> buffer(new uint8_t[length]);
+    ser::OStream ostream(buffer.get(), length);
+    ser::serialize(ostream, msg);
+    M received;
+    ser::IStream istream(buffer.get(), length);
+    ser::deserialize(istream, received);
+    mNumMessages++;
+    mNumBytes += length;
+    return received;
+  }
+
+  size_t numMessages() const { return mNumMessages; }
+  size_t numBytes() const { return mNumBytes; }
+
+ private:
+  size_t mNumMessages = 0;
+  size_t mNumBytes = 0;
+};
+
+struct BenchmarkOptions {
+  unsigned numRobots = 5;
+  bool minCutPartition = false;
+  double partitionImbalance = 0.05;
+  // Directory of the binary cache of split g2o datasets (disabled if empty)
+  std::string cacheDirectory;
+  unsigned maxIterations = 1000;
+  double relChangeTol = 0.2;
+  bool packedPublicPoses = false;
+  // Virtual one-way latency added for each message on the critical path
+  double latencyMs = 0;
+  unsigned maxInitSteps = 30;
+  // Number of simulated GNC weight updates used to time the data matrix updates
+  unsigned weightUpdates = 0;
+  // Number of poses of the trajectory used to time the visualization messages
+  unsigned conversionPoses = 0;
+};
+
+struct BenchmarkResult {
+  bool initialized = false;
+  unsigned numRobots = 0;
+  unsigned numPoses = 0;
+  size_t sharedLoopClosures = 0;
+  unsigned iterations = 0;
+  double initTimeSec = 0;
+  double totalTimeSec = 0;
+  double virtualTimeSec = 0;
+  size_t messages = 0;
+  size_t bytes = 0;
+  double cost = 0;
+  // Time spent updating the quadratic matrices after weight updates
+  double weightRebuildTimeSec = 0;
+  double weightIncrementalTimeSec = 0;
+};
+
+/**
+DPGO agent that exchanges messages over the in-memory bus instead of ROS topics. This
+is not a PGOAgentROS, so the benchmark measures the solver and the size of the
+messages, but not the node's callbacks, scheduling or delta encoding.
+*/
+class SimulatedAgent : public PGOAgent {
+ public:
+  SimulatedAgent(unsigned ID, const PGOAgentParameters &params, bool packed)
+      : PGOAgent(ID, params), mPacked(packed) {}
+
+  // Send public poses to all neighbors, same as PGOAgentROS::publishPublicPoses
+  void publishPublicPoses(MessageBus &bus,
+                          std::vector<std::unique_ptr<SimulatedAgent>> &team) {
+    for (unsigned neighbor : getNeighbors()) {
+      PoseDict map;
+      if (!getSharedPoseDictWithNeighbor(map, neighbor)) return;
+      if (map.empty()) continue;
+      PoseDict received;
+      if (mPacked) {
+        PackedPublicPoses msg;
+        msg.robot_id = getID();
+        msg.destination_robot_id = neighbor;
+        msg.instance_number = instance_number();
+        msg.iteration_number = iteration_number();
+        msg.is_auxiliary = false;
+        PoseDictToPackedMsg(map, msg);
+        if (!PoseDictFromPackedMsg(bus.transmit(msg), received)) continue;
+      } else {
+        PublicPoses msg;
+        msg.robot_id = getID();
+        msg.destination_robot_id = neighbor;
+        msg.instance_number = instance_number();
+        msg.iteration_number = iteration_number();
+        msg.is_auxiliary = false;
+        for (const auto &sharedPose : map) {
+          msg.pose_ids.push_back(sharedPose.first.frame_id);
+          msg.poses.push_back(MatrixToMsg(sharedPose.second.getData()));
+        }
+        const PublicPoses msgOut = bus.transmit(msg);
+        for (size_t index = 0; index < msgOut.pose_ids.size(); ++index) {
+          const PoseID nID(msgOut.robot_id, msgOut.pose_ids.at(index));
+          received.emplace(nID, MatrixFromMsg(msgOut.poses.at(index)));
+        }
+      }
+      team.at(neighbor)->updateNeighborPoses(getID(), received);
+    }
+  }
+
+  // Send status to all robots, same as PGOAgentROS::publishStatus
+  void publishStatus(MessageBus &bus,
+                     std::vector<std::unique_ptr<SimulatedAgent>> &team) {
+    const Status msg = statusToMsg(getStatus());
+    for (auto &agent : team) {
+      if (agent->getID() == getID()) {
+        agent->setNeighborStatus(getStatus());
+      } else {
+        agent->setNeighborStatus(statusFromMsg(bus.transmit(msg)));
+      }
+    }
+  }
+
+ private:
+  bool mPacked;
+};
+
+/**
+Load a dataset in g2o format and split it between robots (same as the dataset
+publisher, including the optional binary cache).
+*/
+bool loadG2O(const std::string &filename,
+             const BenchmarkOptions &options,
+             std::vector<RobotMeasurements> &robot_measurements) {
+  const unsigned num_robots = options.numRobots;
+  const std::string partition_method =
+      options.minCutPartition ? "MinCut" : "Contiguous";
+  std::string cache_file;
+  std::string cache_key;
+  size_t num_poses = 0;
+  std::vector<std::vector<DatasetEdge>> robot_edges;
+  if (!options.cacheDirectory.empty()) {
+    cache_key = datasetCacheKey(
+        filename, num_robots, partition_method, options.partitionImbalance);
+    cache_file = datasetCacheFile(options.cacheDirectory, filename, cache_key);
+  }
+  if (cache_key.empty() ||
+      !readDatasetCache(cache_file, cache_key, num_poses, robot_edges) ||
+      robot_edges.size() != num_robots) {
+    std::vector<DatasetEdge> dataset;
+    if (!parseG2OFile(filename, dataset, num_poses)) return false;
+    const auto assignment =
+        options.minCutPartition
+            ? minCutPoseAssignment(
+                  num_poses, poseEdges(dataset), num_robots, options.partitionImbalance)
+            : contiguousPoseAssignment(num_poses, num_robots);
+    if (assignment.empty()) {
+      std::cerr << "Number of robots must be smaller than total number of poses!"
+                << std::endl;
+      return false;
+    }
+    robot_edges = splitDatasetEdges(dataset, assignment, num_robots);
+    if (!cache_key.empty() &&
+        !writeDatasetCache(cache_file, cache_key, num_poses, robot_edges)) {
+      std::cerr << "Failed to save dataset cache " << cache_file << std::endl;
+    }
+  }
+
+  robot_measurements.assign(num_robots, RobotMeasurements());
+  for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+    auto &measurements = robot_measurements[robot_id];
+    for (const auto &edge : robot_edges[robot_id]) {
+      const auto m = DatasetEdgeToMeasurement(edge);
+      // Local indices of MinCut partitions may be consecutive without odometry
+      if (m.r1 != m.r2) {
+        measurements.sharedLoopClosures.push_back(m);
+      } else if (edge.odometry) {
+        measurements.odometry.push_back(m);
+      } else {
+        measurements.privateLoopClosures.push_back(m);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+Load a dataset stored as <directory>/robot<ID>/measurements.csv (e.g., data/tunnels).
+*/
+bool loadMeasurementDirectory(const std::string &directory,
+                              std::vector<RobotMeasurements> &robot_measurements) {
+  robot_measurements.clear();
+  for (unsigned robot_id = 0;; ++robot_id) {
+    const auto filename = std::filesystem::path(directory) /
+                          ("robot" + std::to_string(robot_id)) / "measurements.csv";
+    if (!std::filesystem::exists(filename)) break;
+    RobotMeasurements measurements;
+    for (const auto &m : PGOLogger::loadMeasurements(filename.string(), false)) {
+      if (m.r1 != m.r2) {
+        measurements.sharedLoopClosures.push_back(m);
+      } else if (m.p1 + 1 == m.p2) {
+        measurements.odometry.push_back(m);
+      } else {
+        measurements.privateLoopClosures.push_back(m);
+      }
+    }
+    robot_measurements.push_back(measurements);
+  }
+  if (robot_measurements.size() < 2) {
+    std::cerr << "Found less than two robots in " << directory << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+Shared loop closures without duplicates. In the ROS nodes, robots exchange their shared
+loop closures before optimization.
+*/
+std::vector<RelativeSEMeasurement> collectSharedLoopClosures(
+    const std::vector<RobotMeasurements> &robot_measurements) {
+  std::map<std::tuple<size_t, size_t, size_t, size_t>, RelativeSEMeasurement> shared;
+  for (const auto &measurements : robot_measurements) {
+    for (const auto &m : measurements.sharedLoopClosures) {
+      shared.emplace(std::make_tuple(m.r1, m.p1, m.r2, m.p2), m);
+    }
+  }
+  std::vector<RelativeSEMeasurement> output;
+  for (const auto &it : shared) output.push_back(it.second);
+  return output;
+}
+
+/**
+Cost of the rounded SE(d) trajectories.
+*/
+double computeCost(const std::vector<PoseArray> &trajectories,
+                   const std::vector<RelativeSEMeasurement> &measurements) {
+  double cost = 0;
+  for (const auto &m : measurements) {
+    const PoseArray &T1 = trajectories.at(m.r1);
+    const PoseArray &T2 = trajectories.at(m.r2);
+    const Matrix R1 = T1.rotation(m.p1);
+    const Matrix R2 = T2.rotation(m.p2);
+    const Vector t1 = T1.translation(m.p1);
+    const Vector t2 = T2.translation(m.p2);
+    cost += m.kappa * (R2 - R1 * m.R).squaredNorm();
+    cost += m.tau * (t2 - t1 - R1 * m.t).squaredNorm();
+  }
+  return cost;
+}
+
+/**
+Run synchronous distributed optimization with the RoundRobin update rule, following
+the protocol of the ROS nodes without the sleeps and timers used to wait for messages.
+The virtual time is the optimization time of the updating robots plus the virtual
+latency of the messages on the critical path.
+*/
+BenchmarkResult runBenchmark(const std::vector<RobotMeasurements> &robot_measurements,
+                             const BenchmarkOptions &options) {
+  BenchmarkResult result;
+  const auto start_time = Clock::now();
+  const unsigned num_robots = robot_measurements.size();
+  const double latency_sec = 1e-3 * options.latencyMs;
+  result.numRobots = num_robots;
+
+  PGOAgentParameters params(3, 5, num_robots);
+  params.localOptimizationParams.method = ROptParameters::ROptMethod::RTR;
+  params.localOptimizationParams.RTR_iterations = 3;
+  params.localOptimizationParams.RTR_tCG_iterations = 50;
+  params.localOptimizationParams.gradnorm_tol = 0.5;
+  params.localInitializationMethod = InitializationMethod::Chordal;
+  params.relChangeTol = options.relChangeTol;
+  params.maxNumIters = options.maxIterations;
+  params.verbose = false;
+  params.logData = false;
+
+  const auto shared_loop_closures = collectSharedLoopClosures(robot_measurements);
+  result.sharedLoopClosures = shared_loop_closures.size();
+  std::vector<std::unique_ptr<SimulatedAgent>> team;
+  for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+    std::vector<RelativeSEMeasurement> shared;
+    for (const auto &m : shared_loop_closures) {
+      if (m.r1 == robot_id || m.r2 == robot_id) shared.push_back(m);
+    }
+    team.push_back(
+        std::make_unique<SimulatedAgent>(robot_id, params, options.packedPublicPoses));
+    team.back()->setMeasurements(robot_measurements[robot_id].odometry,
+                                 robot_measurements[robot_id].privateLoopClosures,
+                                 shared);
+    result.numPoses += team.back()->num_poses();
+  }
+
+  MessageBus bus;
+
+  // Initialization
+  for (auto &agent : team) agent->initialize();
+  team[0]->initializeInGlobalFrame(Pose(3));
+  Matrix YLift;
+  if (!team[0]->getLiftingMatrix(YLift)) {
+    std::cerr << "Lifting matrix is not available!" << std::endl;
+    return result;
+  }
+  const MatrixMsg lifting_matrix_msg = MatrixToMsg(YLift);
+  for (unsigned robot_id = 1; robot_id < num_robots; ++robot_id) {
+    team[robot_id]->setLiftingMatrix(MatrixFromMsg(bus.transmit(lifting_matrix_msg)));
+  }
+  for (unsigned step = 0; step < options.maxInitSteps && !result.initialized; ++step) {
+    for (auto &agent : team) agent->publishStatus(bus, team);
+    for (auto &agent : team) agent->publishPublicPoses(bus, team);
+    result.initialized = true;
+    for (auto &agent : team) {
+      if (agent->getStatus().state != PGOAgentState::INITIALIZED)
+        result.initialized = false;
+    }
+    result.virtualTimeSec += latency_sec;
+  }
+  result.initTimeSec = secondsSince(start_time);
+  if (!result.initialized) {
+    std::cerr << "Not all robots initialized in global frame!" << std::endl;
+    return result;
+  }
+
+  // Distributed optimization
+  unsigned selected_robot = 0;
+  for (unsigned iter = 0; iter < options.maxIterations; ++iter) {
+    // UPDATE command sent to all robots
+    Command command;
+    command.command = Command::UPDATE;
+    command.publishing_robot = selected_robot;
+    command.executing_robot = selected_robot;
+    command.executing_robots.push_back(selected_robot);
+    command.executing_iteration = iter + 1;
+    for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+      if (robot_id != selected_robot) bus.transmit(command);
+    }
+
+    const auto iteration_start_time = Clock::now();
+    for (auto &agent : team) agent->iterate(agent->getID() == selected_robot);
+    team[selected_robot]->publishPublicPoses(bus, team);
+    result.virtualTimeSec += secondsSince(iteration_start_time) + 2 * latency_sec;
+    for (auto &agent : team) agent->publishStatus(bus, team);
+    result.iterations++;
+
+    if (team[0]->shouldTerminate()) break;
+    selected_robot = (selected_robot + 1) % num_robots;
+  }
+
+  // Express all trajectories in the global frame of the first robot
+  Matrix T0;
+  team[0]->getSharedPose(0, T0);
+  PublicPoses anchor_msg;
+  anchor_msg.robot_id = 0;
+  anchor_msg.pose_ids.push_back(0);
+  anchor_msg.poses.push_back(MatrixToMsg(T0));
+  for (auto &agent : team) {
+    agent->setGlobalAnchor(MatrixFromMsg(bus.transmit(anchor_msg).poses[0]));
+  }
+  result.totalTimeSec = secondsSince(start_time);
+  result.messages = bus.numMessages();
+  result.bytes = bus.numBytes();
+
+  std::vector<PoseArray> trajectories;
+  std::vector<RelativeSEMeasurement> measurements = shared_loop_closures;
+  for (unsigned robot_id = 0; robot_id < num_robots; ++robot_id) {
+    PoseArray T(3, team[robot_id]->num_poses());
+    team[robot_id]->getTrajectoryInGlobalFrame(T);
+    trajectories.push_back(T);
+    const auto &robot = robot_measurements[robot_id];
+    measurements.insert(
+        measurements.end(), robot.odometry.begin(), robot.odometry.end());
+    measurements.insert(measurements.end(),
+                        robot.privateLoopClosures.begin(),
+                        robot.privateLoopClosures.end());
+  }
+  result.cost = computeCost(trajectories, measurements);
+  return result;
+}
+
+/**
+Time the quadratic matrix updates after each robot receives new weights for all of
+its shared loop closures, as in distributed GNC. The matrices are either rebuilt from
+scratch (DPGO default) or updated in place (PoseGraphROS::setSharedLoopClosureWeight).
+*/
+bool runWeightUpdateBenchmark(const std::vector<RobotMeasurements> &robot_measurements,
+                              const BenchmarkOptions &options,
+                              BenchmarkResult &result) {
+  const auto shared_loop_closures = collectSharedLoopClosures(robot_measurements);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> weight_distribution(0, 1);
+  bool consistent = true;
+  for (unsigned robot_id = 0; robot_id < robot_measurements.size(); ++robot_id) {
+    PoseGraphROS rebuilt_graph(robot_id, 5, 3);
+    PoseGraphROS incremental_graph(robot_id, 5, 3);
+    std::vector<RelativeSEMeasurement> measurements;
+    const auto &robot = robot_measurements[robot_id];
+    measurements.insert(
+        measurements.end(), robot.odometry.begin(), robot.odometry.end());
+    measurements.insert(measurements.end(),
+                        robot.privateLoopClosures.begin(),
+                        robot.privateLoopClosures.end());
+    std::vector<RelativeSEMeasurement> shared;
+    for (const auto &m : shared_loop_closures) {
+      if (m.r1 == robot_id || m.r2 == robot_id) shared.push_back(m);
+    }
+    measurements.insert(measurements.end(), shared.begin(), shared.end());
+    for (const auto &m : measurements) {
+      rebuilt_graph.addMeasurement(m);
+      incremental_graph.addMeasurement(m);
+    }
+    rebuilt_graph.quadraticMatrix();
+    incremental_graph.quadraticMatrix();
+
+    for (unsigned update = 0; update < options.weightUpdates; ++update) {
+      std::vector<double> weights;
+      for (size_t k = 0; k < shared.size(); ++k) {
+        weights.push_back(weight_distribution(rng));
+      }
+      auto start_time = Clock::now();
+      for (size_t k = 0; k < shared.size(); ++k) {
+        const auto &m = shared[k];
+        auto *measurement =
+            rebuilt_graph.findMeasurement(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2));
+        measurement->weight = weights[k];
+      }
+      rebuilt_graph.clearDataMatrices();
+      rebuilt_graph.quadraticMatrix();
+      result.weightRebuildTimeSec += secondsSince(start_time);
+
+      start_time = Clock::now();
+      for (size_t k = 0; k < shared.size(); ++k) {
+        const auto &m = shared[k];
+        incremental_graph.setSharedLoopClosureWeight(
+            PoseID(m.r1, m.p1), PoseID(m.r2, m.p2), weights[k], false);
+      }
+      incremental_graph.quadraticMatrix();
+      result.weightIncrementalTimeSec += secondsSince(start_time);
+    }
+
+    const SparseMatrix &Q = rebuilt_graph.quadraticMatrix();
+    const double error = (Q - incremental_graph.quadraticMatrix()).norm();
+    if (error > 1e-6 * Q.norm()) {
+      std::cerr << "Robot " << robot_id
+                << " quadratic matrix differs after in-place weight updates (error "
+                << error << ")." << std::endl;
+      consistent = false;
+    }
+  }
+  return consistent;
+}
+
+/**
+Time the conversion of a random trajectory to the visualization messages published by
+PGOAgentROS::publishTrajectory, with one conversion per message or with the batched
+conversion.
+*/
+void runConversionBenchmark(unsigned num_poses) {
+  const unsigned d = 3;
+  const int repetitions = 10;
+  Matrix T(d, (d + 1) * num_poses);
+  for (unsigned i = 0; i < num_poses; ++i) {
+    T.block(0, i * (d + 1), d, d) = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+    T.col(i * (d + 1) + d) = Eigen::Vector3d::Random();
+  }
+  ros::Time::init();
+
+  auto start_time = Clock::now();
+  for (int k = 0; k < repetitions; ++k) {
+    const auto pose_array = TrajectoryToPoseArray(d, num_poses, T);
+    const auto path = TrajectoryToPath(d, num_poses, T);
+    const auto pose_graph = TrajectoryToPoseGraphMsg(0, d, num_poses, T);
+  }
+  const double separate_time_sec = secondsSince(start_time) / repetitions;
+
+  start_time = Clock::now();
+  for (int k = 0; k < repetitions; ++k) {
+    geometry_msgs::PoseArray pose_array;
+    nav_msgs::Path path;
+    pose_graph_tools_msgs::PoseGraph pose_graph;
+    TrajectoryToMsgs(0, d, num_poses, T, pose_array, path, pose_graph);
+  }
+  const double batched_time_sec = secondsSince(start_time) / repetitions;
+
+  std::cout << "conversion_poses,separate_time_sec,batched_time_sec\n"
+            << num_poses << "," << separate_time_sec << "," << batched_time_sec
+            << std::endl;
+}
+
+void printUsage() {
+  std::cout
+      << "Usage: dpgo_ros_benchmark [options] DATASET [DATASET...]\n"
+         "Benchmark the DPGO solver with the messages of dpgo_ros. The PGOAgentROS\n"
+         "nodes are not run.\n"
+         "DATASET is a g2o file, or a directory with one robot<ID>/measurements.csv\n"
+         "file per robot (e.g. data/tunnels).\n"
+         "Options:\n"
+         "  --num_robots N                  robots used to split g2o datasets (5)\n"
+         "  --partition_method M            Contiguous or MinCut (Contiguous)\n"
+         "  --partition_imbalance X         maximum imbalance of MinCut (0.05)\n"
+         "  --cache_directory DIR           reuse split g2o datasets stored in DIR\n"
+         "  --max_iteration_number N        maximum number of iterations (1000)\n"
+         "  --relative_change_tolerance X   stopping condition (0.2)\n"
+         "  --public_poses_format F         Matrix or Packed (Matrix)\n"
+         "  --latency_ms X                  virtual one-way message latency (0)\n"
+         "  --weight_updates N              time N simulated GNC weight updates (0)\n"
+         "  --conversion_poses N            time N-pose trajectory messages (0)\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  BenchmarkOptions options;
+  std::vector<std::string> datasets;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--num_robots" && has_value) {
+      options.numRobots = std::stoul(argv[++i]);
+    } else if (arg == "--partition_method" && has_value) {
+      const std::string method = argv[++i];
+      if (method != "Contiguous" && method != "MinCut") {
+        std::cerr << "Unknown partition method: " << method << std::endl;
+        return 1;
+      }
+      options.minCutPartition = method == "MinCut";
+    } else if (arg == "--partition_imbalance" && has_value) {
+      options.partitionImbalance = std::stod(argv[++i]);
+    } else if (arg == "--cache_directory" && has_value) {
+      options.cacheDirectory = argv[++i];
+    } else if (arg == "--max_iteration_number" && has_value) {
+      options.maxIterations = std::stoul(argv[++i]);
+    } else if (arg == "--relative_change_tolerance" && has_value) {
+      options.relChangeTol = std::stod(argv[++i]);
+    } else if (arg == "--public_poses_format" && has_value) {
+      const std::string format = argv[++i];
+      if (format != "Matrix" && format != "Packed") {
+        std::cerr << "Unknown public poses format: " << format << std::endl;
+        return 1;
+      }
+      options.packedPublicPoses = format == "Packed";
+    } else if (arg == "--latency_ms" && has_value) {
+      options.latencyMs = std::stod(argv[++i]);
+    } else if (arg == "--weight_updates" && has_value) {
+      options.weightUpdates = std::stoul(argv[++i]);
+    } else if (arg == "--conversion_poses" && has_value) {
+      options.conversionPoses = std::stoul(argv[++i]);
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage();
+      return 0;
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Invalid option: " << arg << std::endl;
+      printUsage();
+      return 1;
+    } else {
+      datasets.push_back(arg);
+    }
+  }
+  if (options.conversionPoses > 0) {
+    runConversionBenchmark(options.conversionPoses);
+    if (datasets.empty()) return 0;
+  }
+  if (datasets.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  int exit_code = 0;
+  std::cout << "dataset,num_robots,num_poses,shared_loop_closures,iterations,"
+               "init_time_sec,total_time_sec,virtual_time_sec,messages,bytes,cost,"
+               "weight_rebuild_time_sec,weight_incremental_time_sec"
+            << std::endl;
+  for (const auto &dataset : datasets) {
+    std::vector<RobotMeasurements> robot_measurements;
+    bool loaded = std::filesystem::is_directory(dataset)
+                      ? loadMeasurementDirectory(dataset, robot_measurements)
+                      : loadG2O(dataset, options, robot_measurements);
+    if (!loaded) {
+      std::cerr << "Failed to load dataset " << dataset << std::endl;
+      exit_code = 1;
+      continue;
+    }
+    auto result = runBenchmark(robot_measurements, options);
+    if (!result.initialized) exit_code = 1;
+    if (options.weightUpdates > 0 &&
+        !runWeightUpdateBenchmark(robot_measurements, options, result)) {
+      exit_code = 1;
+    }
+    std::cout << dataset << "," << result.numRobots << "," << result.numPoses << ","
+              << result.sharedLoopClosures << "," << result.iterations << ","
+              << result.initTimeSec << "," << result.totalTimeSec << ","
+              << result.virtualTimeSec << "," << result.messages << "," << result.bytes
+              << "," << result.cost << "," << result.weightRebuildTimeSec << ","
+              << result.weightIncrementalTimeSec << std::endl;
+  }
+  return exit_code;
+}
@@ -5,7 +5,9 @@
  * See LICENSE for the license information
  * -------------------------------------------------------------------------- */
 
-#include <DPGO/DPGO_utils.h>
+#include <dpgo_ros/dataset.h>
+#include <dpgo_ros/QueryPoseGraphDelta.h>
+#include <dpgo_ros/partition.h>
 #include <dpgo_ros/utils.h>
 #include <pose_graph_tools_msgs/PoseGraph.h>
 #include <pose_graph_tools_msgs/PoseGraphQuery.h>
@@ -49,6 +51,11 @@ class DatasetPublisher {
       ros::ServiceServer server = nh.advertiseService(
           service_name, &DatasetPublisher::queryPoseGraphCallback, this);
       poseGraphServers.push_back(server);
+      ros::ServiceServer delta_server =
+          nh.advertiseService(service_name + "_delta",
+                              &DatasetPublisher::queryPoseGraphDeltaCallback,
+                              this);
+      poseGraphServers.push_back(delta_server);
     }
   }
 
@@ -71,106 +78,154 @@ class DatasetPublisher {
     return true;
   }
 
+  // Return the edges and nodes after the watermarks of the requesting robot. The
+  // dataset does not change, so only the first request of each robot returns data.
+  bool queryPoseGraphDeltaCallback(dpgo_ros::QueryPoseGraphDeltaRequest &request,
+                                   dpgo_ros::QueryPoseGraphDeltaResponse &response) {
+    if (request.robot_id >= poseGraphs.size()) {
+      ROS_ERROR("DatasetPublisher: requested robot does not exist!");
+      return false;
+    }
+    const auto &pose_graph = poseGraphs[request.robot_id];
+    response.pose_graph = dpgo_ros::poseGraphDelta(
+        pose_graph, request.edge_watermark, request.node_watermark);
+    ROS_INFO("Received delta request from robot %i (%zu new edges).",
+             request.robot_id,
+             response.pose_graph.edges.size());
+    response.edge_watermark = pose_graph.edges.size();
+    response.node_watermark = pose_graph.nodes.size();
+    return true;
+  }
+
   /**
-   * @brief Initialize from a single dataset in g2o format
+   * @brief Initialize from a single dataset in g2o format. If a cache directory is
+   * given, the split dataset is stored there and reused as long as the dataset file and
+   * the partition settings do not change.
    * @param filename
    */
   void loadFromG2O(const std::string &filename) {
-    size_t num_poses;
-    vector<RelativeSEMeasurement> dataset = read_g2o_file(filename, num_poses);
-    ROS_INFO_STREAM("Loaded dataset" << filename << " with " << num_poses
-                                     << " total poses.");
-    unsigned int n = num_poses;
-    unsigned int num_poses_per_robot = n / num_robots;
-    if (num_poses_per_robot <= 0) {
-      ROS_ERROR_STREAM("Number of robots must be smaller than total number of poses!");
+    string partition_method = "Contiguous";
+    ros::param::get("~partition_method", partition_method);
+    double partition_imbalance = 0.05;
+    ros::param::get("~partition_imbalance", partition_imbalance);
+    string cache_directory;
+    ros::param::get("~cache_directory", cache_directory);
+    // Robots may own non-contiguous blocks of poses with MinCut. DPGO treats every
+    // measurement between consecutive local poses as odometry, so the odometry chain
+    // used by these settings would be broken.
+    string local_initialization_method = "Odometry";
+    ros::param::get("~local_initialization_method", local_initialization_method);
+    string robust_cost_type = "L2";
+    ros::param::get("~robust_cost_type", robust_cost_type);
+    if (partition_method == "MinCut" &&
+        (local_initialization_method != "Chordal" ||
+         robust_cost_type.rfind("GNC", 0) == 0)) {
+      ROS_ERROR_STREAM("MinCut partition requires Chordal local initialization and "
+                       "cannot be used with GNC (got "
+                       << local_initialization_method << " and " << robust_cost_type
+                       << ")!");
+      return;
     }
 
-    ROS_INFO_STREAM("Creating mapping from global pose index to local pose index...");
-    map<unsigned, PoseID> PoseMap;
-    for (unsigned robot = 0; robot < (unsigned)num_robots; ++robot) {
-      unsigned startIdx = robot * num_poses_per_robot;
-      unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
-      if (robot == (unsigned)num_robots - 1) endIdx = n;
-      for (unsigned idx = startIdx; idx < endIdx; ++idx) {
-        unsigned localIdx = idx - startIdx;  // this is the local ID of this pose
-        PoseID pose(robot, localIdx);
-        PoseMap[idx] = pose;
+    string cache_file;
+    string cache_key;
+    size_t num_poses = 0;
+    vector<vector<dpgo_ros::DatasetEdge>> robot_edges;
+    if (!cache_directory.empty()) {
+      cache_key = dpgo_ros::datasetCacheKey(
+          filename, num_robots, partition_method, partition_imbalance);
+      cache_file = dpgo_ros::datasetCacheFile(cache_directory, filename, cache_key);
+      if (!cache_key.empty() &&
+          dpgo_ros::readDatasetCache(cache_file, cache_key, num_poses, robot_edges) &&
+          robot_edges.size() == (unsigned)num_robots) {
+        ROS_INFO_STREAM("Loaded dataset " << filename << " with " << num_poses
+                                          << " total poses from cache " << cache_file
+                                          << ".");
+        setPoseGraphs(robot_edges);
+        return;
       }
     }
 
-    vector<vector<RelativeSEMeasurement>> odometry(num_robots);
-    vector<vector<RelativeSEMeasurement>> private_loop_closures(num_robots);
-    vector<vector<RelativeSEMeasurement>> shared_loop_closure(num_robots);
-    for (size_t k = 0; k < dataset.size(); ++k) {
-      RelativeSEMeasurement mIn = dataset[k];
-      PoseID src = PoseMap[mIn.p1];
-      PoseID dst = PoseMap[mIn.p2];
-
-      unsigned srcRobot = src.robot_id;
-      unsigned srcIdx = src.frame_id;
-      unsigned dstRobot = dst.robot_id;
-      unsigned dstIdx = dst.frame_id;
-
-      RelativeSEMeasurement m(
-          srcRobot, dstRobot, srcIdx, dstIdx, mIn.R, mIn.t, mIn.kappa, mIn.tau);
-
-      if (srcRobot == dstRobot) {
-        // private measurement
-        if (srcIdx + 1 == dstIdx) {
-          // Odometry
-          odometry[srcRobot].push_back(m);
-        } else {
-          // private loop closure
-          private_loop_closures[srcRobot].push_back(m);
-        }
-      } else {
-        // shared measurement
-        shared_loop_closure[srcRobot].push_back(m);
-        // shared_loop_closure[dstRobot].push_back(m);
-      }
+    vector<dpgo_ros::DatasetEdge> dataset;
+    if (!dpgo_ros::parseG2OFile(filename, dataset, num_poses)) {
+      ROS_ERROR_STREAM("Failed to read 3D dataset " << filename << "!");
+      return;
+    }
+    ROS_INFO_STREAM("Loaded dataset " << filename << " with " << num_poses
+                                      << " total poses.");
+    // Assign poses to robots
+    const auto pose_edges = dpgo_ros::poseEdges(dataset);
+    vector<PoseID> assignment;
+    if (partition_method == "Contiguous") {
+      assignment = dpgo_ros::contiguousPoseAssignment(num_poses, num_robots);
+    } else if (partition_method == "MinCut") {
+      assignment = dpgo_ros::minCutPoseAssignment(
+          num_poses, pose_edges, num_robots, partition_imbalance);
+    } else {
+      ROS_ERROR_STREAM("Unknown partition method: " << partition_method);
+      return;
+    }
+    if (assignment.empty()) {
+      ROS_ERROR_STREAM("Number of robots must be smaller than total number of poses!");
+      return;
     }
 
+    // Report the size of each robot's pose graph and the shared loop closures
+    vector<size_t> robot_num_poses(num_robots, 0);
+    for (const auto &pose_id : assignment) robot_num_poses[pose_id.robot_id]++;
+    const auto cuts = dpgo_ros::computeEdgeCuts(assignment, pose_edges, num_robots);
+    size_t total_cut = 0;
     for (size_t robot = 0; robot < (unsigned)num_robots; ++robot) {
-      pose_graph_tools_msgs::PoseGraph pose_graph;
-      // Add odometry factors
-      for (size_t k = 0; k < odometry[robot].size(); ++k) {
-        pose_graph_tools_msgs::PoseGraphEdge edge =
-            dpgo_ros::RelativeMeasurementToMsg(odometry[robot][k]);
-        pose_graph.edges.push_back(edge);
-      }
-      // Add private loop closures
-      for (size_t k = 0; k < private_loop_closures[robot].size(); ++k) {
-        pose_graph_tools_msgs::PoseGraphEdge edge =
-            dpgo_ros::RelativeMeasurementToMsg(private_loop_closures[robot][k]);
-        pose_graph.edges.push_back(edge);
-      }
-      // Add shared loop closures
-      for (size_t k = 0; k < shared_loop_closure[robot].size(); ++k) {
-        pose_graph_tools_msgs::PoseGraphEdge edge =
-            dpgo_ros::RelativeMeasurementToMsg(shared_loop_closure[robot][k]);
-        pose_graph.edges.push_back(edge);
+      ROS_INFO("Robot %zu: %zu poses, %zu shared loop closures.",
+               robot,
+               robot_num_poses[robot],
+               cuts[robot]);
+      total_cut += cuts[robot];
+    }
+    ROS_INFO_STREAM(partition_method << " partition has " << total_cut / 2
+                                     << " shared loop closures in total.");
+    robot_edges = dpgo_ros::splitDatasetEdges(dataset, assignment, num_robots);
+
+    if (!cache_key.empty()) {
+      if (dpgo_ros::writeDatasetCache(cache_file, cache_key, num_poses, robot_edges)) {
+        ROS_INFO_STREAM("Saved dataset cache " << cache_file << ".");
+      } else {
+        ROS_WARN_STREAM("Failed to save dataset cache " << cache_file << ".");
       }
-      poseGraphs.push_back(pose_graph);
     }
+    setPoseGraphs(robot_edges);
   }
 
   void loadFromMeasurements() {
     for (size_t robot_id = 0; robot_id < (unsigned)num_robots; ++robot_id) {
-      pose_graph_tools_msgs::PoseGraph pose_graph;
       std::string measurement_file;
       if (!ros::param::get("~robot" + std::to_string(robot_id) + "_measurements",
                            measurement_file)) {
         ROS_ERROR("No measurement file specified for robot %zu!", robot_id);
       }
-      std::vector<RelativeSEMeasurement> measurements =
-          PGOLogger::loadMeasurements(measurement_file, false);
-      for (const auto &m : measurements) {
-        pose_graph_tools_msgs::PoseGraphEdge edge =
-            dpgo_ros::RelativeMeasurementToMsg(m);
-        pose_graph.edges.push_back(edge);
+      vector<dpgo_ros::DatasetEdge> measurements;
+      if (!dpgo_ros::parseMeasurementsFile(measurement_file, measurements)) {
+        ROS_ERROR_STREAM("Failed to read measurement file " << measurement_file << "!");
       }
-      poseGraphs.push_back(pose_graph);
+      poseGraphs.push_back(makePoseGraph(measurements));
+    }
+  }
+
+  static pose_graph_tools_msgs::PoseGraph makePoseGraph(
+      const vector<dpgo_ros::DatasetEdge> &edges) {
+    pose_graph_tools_msgs::PoseGraph pose_graph;
+    pose_graph.edges.reserve(edges.size());
+    for (const auto &edge : edges) {
+      pose_graph.edges.push_back(dpgo_ros::DatasetEdgeToMsg(edge));
+    }
+    return pose_graph;
+  }
+
+  void setPoseGraphs(const vector<vector<dpgo_ros::DatasetEdge>> &robot_edges) {
+    poseGraphs.clear();
+    poseGraphs.reserve(robot_edges.size());
+    for (const auto &edges : robot_edges) {
+      poseGraphs.push_back(makePoseGraph(edges));
     }
   }
 };
@@ -0,0 +1,40 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/AsyncBinaryLogger.h>
+
+#include <iostream>
+#include <string>
+
+/**
+This script converts binary iteration logs (written with ~binary_log) to the CSV
+iteration log
+*/
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: dpgo_ros_log_converter BINARY_LOG [CSV_LOG]\n"
+                 "Convert a binary iteration log to CSV. By default, the CSV log is "
+                 "written next to the binary log with the .csv extension."
+              << std::endl;
+    return 1;
+  }
+  const std::string binary_file = argv[1];
+  std::string csv_file;
+  if (argc == 3) {
+    csv_file = argv[2];
+  } else {
+    const size_t extension = binary_file.rfind(".bin");
+    csv_file = binary_file.substr(0, extension) + ".csv";
+  }
+  if (!dpgo_ros::convertBinaryIterationLog(binary_file, csv_file)) {
+    std::cerr << "Failed to convert " << binary_file << " to " << csv_file << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << csv_file << std::endl;
+  return 0;
+}
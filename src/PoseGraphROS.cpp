@@ -0,0 +1,70 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/PoseGraphROS.h>
+
+using namespace DPGO;
+
+namespace dpgo_ros {
+
+PoseGraphROS::PoseGraphROS(unsigned int id, unsigned int r, unsigned int d)
+    : PoseGraph(id, r, d), mNumIncrementalUpdates(0) {}
+
+bool PoseGraphROS::setSharedLoopClosureWeight(const PoseID &src_id,
+                                              const PoseID &dst_id,
+                                              double weight,
+                                              bool fixed_weight) {
+  RelativeSEMeasurement *m = findMeasurement(src_id, dst_id);
+  if (!m || m->r1 == m->r2) return false;
+  const double weight_change = weight - m->weight;
+  m->weight = weight;
+  m->fixedWeight = fixed_weight;
+  if (weight_change == 0) return true;
+
+  // The linear matrix and the preconditioner are rebuilt on the next iteration
+  G_.reset();
+  precon_.reset();
+  if (!Q_) return true;
+  // Loop closures with inactive neighbors are not included in the quadratic matrix
+  const unsigned int neighbor_id = m->r1 == id_ ? m->r2 : m->r1;
+  if (!use_inactive_neighbors_ && !isNeighborActive(neighbor_id)) return true;
+
+  // Only the diagonal block of the local pose depends on the weight
+  const size_t pose_id = m->r1 == id_ ? m->p1 : m->p2;
+  const Matrix block = weight_change * sharedLoopClosureBlock(*m, id_);
+  SparseMatrix &Q = Q_.value();
+  for (unsigned int row = 0; row < d_ + 1; ++row) {
+    for (unsigned int col = 0; col < d_ + 1; ++col) {
+      if (block(row, col) == 0) continue;
+      Q.coeffRef(pose_id * (d_ + 1) + row, pose_id * (d_ + 1) + col) +=
+          block(row, col);
+    }
+  }
+  Q.makeCompressed();
+  mNumIncrementalUpdates++;
+  return true;
+}
+
+Matrix PoseGraphROS::sharedLoopClosureBlock(const RelativeSEMeasurement &m,
+                                            unsigned int robot_id) {
+  const unsigned int d = m.R.rows();
+  // Precision matrix in homogeneous form
+  Matrix Omega = Matrix::Zero(d + 1, d + 1);
+  Omega.topLeftCorner(d, d).diagonal().setConstant(m.kappa);
+  Omega(d, d) = m.tau;
+  if (m.r1 != robot_id) {
+    // Incoming edge: the local pose is the second pose
+    return Omega;
+  }
+  // Outgoing edge: the local pose is the first pose
+  Matrix T = Matrix::Identity(d + 1, d + 1);
+  T.topLeftCorner(d, d) = m.R;
+  T.topRightCorner(d, 1) = m.t;
+  return T * Omega * T.transpose();
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,67 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/SharedLoopClosureTracker.h>
+
+#include <chrono>
+#include <utility>
+
+namespace dpgo_ros {
+
+uint64_t SharedLoopClosureTracker::newEpoch() {
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+bool SharedLoopClosureTracker::isAcknowledged(unsigned robot_id,
+                                              const DPGO::EdgeID &edge_id) const {
+  const auto it = mAcknowledged.find(robot_id);
+  return it != mAcknowledged.end() && it->second.find(edge_id) != it->second.end();
+}
+
+void SharedLoopClosureTracker::addPending(unsigned robot_id,
+                                          uint32_t sequence,
+                                          std::vector<DPGO::EdgeID> edges) {
+  mPending[robot_id].push_back({sequence, std::move(edges)});
+}
+
+void SharedLoopClosureTracker::acknowledge(unsigned robot_id, uint32_t sequence) {
+  auto it = mPending.find(robot_id);
+  if (it == mPending.end()) return;
+  auto &pending = it->second;
+  auto &acknowledged = mAcknowledged[robot_id];
+  auto last = pending.begin();
+  while (last != pending.end() && last->sequence <= sequence) {
+    acknowledged.insert(last->edges.begin(), last->edges.end());
+    ++last;
+  }
+  pending.erase(pending.begin(), last);
+}
+
+bool SharedLoopClosureTracker::updateEpoch(unsigned robot_id, uint64_t epoch) {
+  const auto it = mEpochs.find(robot_id);
+  if (it == mEpochs.end()) {
+    mEpochs.emplace(robot_id, epoch);
+    return false;
+  }
+  if (it->second == epoch) return false;
+  it->second = epoch;
+  // The robot no longer has the shared loop closures sent to it earlier, including
+  // those in messages that are not acknowledged yet
+  mAcknowledged.erase(robot_id);
+  mPending.erase(robot_id);
+  return true;
+}
+
+void SharedLoopClosureTracker::clearPending() { mPending.clear(); }
+
+void SharedLoopClosureTracker::clear() {
+  mPending.clear();
+  mAcknowledged.clear();
+}
+
+}  // namespace dpgo_ros
@@ -0,0 +1,434 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/dataset.h>
+#include <dpgo_ros/utils.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+namespace dpgo_ros {
+
+namespace {
+
+// Read the whole file into a null-terminated buffer
+bool readFile(const std::string &filename, std::vector<char> &buffer) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  buffer.resize(st.st_size + 1);
+  size_t num_read = 0;
+  while (num_read < (size_t)st.st_size) {
+    const ssize_t n = ::read(fd, buffer.data() + num_read, st.st_size - num_read);
+    if (n <= 0) break;
+    num_read += n;
+  }
+  ::close(fd);
+  buffer.resize(num_read + 1);
+  buffer[num_read] = '\0';
+  return num_read == (size_t)st.st_size;
+}
+
+// Read-only memory mapping of a file, unmapped on destruction
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        mData = static_cast<const char *>(data);
+        mSize = st.st_size;
+      }
+    }
+    ::close(fd);
+  }
+  ~MappedFile() {
+    if (mData) ::munmap(const_cast<char *>(mData), mSize);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return mData; }
+  size_t size() const { return mSize; }
+
+ private:
+  const char *mData = nullptr;
+  size_t mSize = 0;
+};
+
+// Tokenizer over a null-terminated buffer. Tokens are separated by spaces, tabs or
+// commas, and never extend past the end of the current line.
+class LineTokenizer {
+ public:
+  explicit LineTokenizer(const char *buffer) : mPos(buffer) {}
+
+  bool atEnd() const { return *mPos == '\0'; }
+
+  void nextLine() {
+    while (*mPos != '\0' && *mPos != '\n') ++mPos;
+    if (*mPos == '\n') ++mPos;
+  }
+
+  bool readToken(std::string_view &token) {
+    skipSeparators();
+    const char *begin = mPos;
+    while (*mPos != '\0' && !isSeparator(*mPos) && *mPos != '\n') ++mPos;
+    token = std::string_view(begin, mPos - begin);
+    return !token.empty();
+  }
+
+  bool readDouble(double &value) {
+    skipSeparators();
+    if (*mPos == '\0' || *mPos == '\n') return false;
+    char *end = nullptr;
+    value = std::strtod(mPos, &end);
+    if (end == mPos) return false;
+    mPos = end;
+    return true;
+  }
+
+  bool readIndex(uint64_t &value) {
+    skipSeparators();
+    // strtoull accepts (and negates) a leading minus sign
+    if (*mPos < '0' || *mPos > '9') return false;
+    char *end = nullptr;
+    value = std::strtoull(mPos, &end, 10);
+    mPos = end;
+    return true;
+  }
+
+ private:
+  static bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+  }
+  void skipSeparators() {
+    while (isSeparator(*mPos)) ++mPos;
+  }
+
+  const char *mPos;
+};
+
+bool readDoubles(LineTokenizer &tokenizer, double *values, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!tokenizer.readDouble(values[i])) return false;
+  }
+  return true;
+}
+
+bool normalizeQuaternion(double *q) {
+  const double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  if (!(norm > 0)) return false;
+  for (size_t i = 0; i < 4; ++i) q[i] /= norm;
+  return true;
+}
+
+// Weights of the rotation and translation measurements from the upper triangular part
+// of the 6x6 information matrix (translation first), same as DPGO::read_g2o_file
+void setWeightsFromInformation(const double *upper, DatasetEdge &edge) {
+  Eigen::Matrix<double, 6, 6> information;
+  size_t k = 0;
+  for (int row = 0; row < 6; ++row) {
+    for (int col = row; col < 6; ++col) {
+      information(row, col) = upper[k];
+      information(col, row) = upper[k];
+      ++k;
+    }
+  }
+  const Eigen::Matrix3d TranCov = information.block<3, 3>(0, 0).inverse();
+  const Eigen::Matrix3d RotCov = information.block<3, 3>(3, 3).inverse();
+  edge.tau = 3 / TranCov.trace();
+  edge.kappa = 3 / (2 * RotCov.trace());
+}
+
+constexpr char kCacheMagic[8] = {'D', 'P', 'G', 'O', 'E', 'D', 'G', 'E'};
+constexpr uint32_t kCacheVersion = 2;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t numRobots;
+  uint64_t numPoses;
+  uint64_t keyLength;
+};
+
+// The key is padded so that the edge counts and records stay 8-byte aligned
+size_t paddedKeyLength(size_t key_length) { return (key_length + 7) / 8 * 8; }
+
+// 64-bit FNV-1a hash, stable across compilers and runs
+uint64_t hashKey(const std::string &key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool parseG2OFile(const std::string &filename,
+                  std::vector<DatasetEdge> &edges,
+                  size_t &num_poses) {
+  edges.clear();
+  num_poses = 0;
+  std::vector<char> buffer;
+  if (!readFile(filename, buffer)) return false;
+
+  LineTokenizer tokenizer(buffer.data());
+  while (!tokenizer.atEnd()) {
+    std::string_view type;
+    if (tokenizer.readToken(type)) {
+      if (type == "EDGE_SE3:QUAT") {
+        DatasetEdge edge{};
+        double information[21];
+        if (!tokenizer.readIndex(edge.p1) || !tokenizer.readIndex(edge.p2) ||
+            !readDoubles(tokenizer, edge.translation, 3) ||
+            !readDoubles(tokenizer, edge.quaternion, 4) ||
+            !readDoubles(tokenizer, information, 21) ||
+            !normalizeQuaternion(edge.quaternion)) {
+          return false;
+        }
+        setWeightsFromInformation(information, edge);
+        edge.odometry = edge.p1 + 1 == edge.p2;
+        num_poses = std::max<size_t>(num_poses, std::max(edge.p1, edge.p2) + 1);
+        edges.push_back(edge);
+      } else if (type.substr(0, 6) != "VERTEX" && type != "FIX") {
+        // Only 3D pose graphs are supported
+        return false;
+      }
+    }
+    tokenizer.nextLine();
+  }
+  return true;
+}
+
+bool parseMeasurementsFile(const std::string &filename,
+                           std::vector<DatasetEdge> &edges) {
+  edges.clear();
+  std::vector<char> buffer;
+  if (!readFile(filename, buffer)) return false;
+
+  LineTokenizer tokenizer(buffer.data());
+  // Skip header
+  tokenizer.nextLine();
+  while (!tokenizer.atEnd()) {
+    DatasetEdge edge{};
+    if (tokenizer.readIndex(edge.r1)) {
+      if (!tokenizer.readIndex(edge.p1) || !tokenizer.readIndex(edge.r2) ||
+          !tokenizer.readIndex(edge.p2) ||
+          !readDoubles(tokenizer, edge.quaternion, 4) ||
+          !readDoubles(tokenizer, edge.translation, 3) ||
+          !tokenizer.readDouble(edge.kappa) || !tokenizer.readDouble(edge.tau) ||
+          !normalizeQuaternion(edge.quaternion)) {
+        return false;
+      }
+      edge.odometry = edge.r1 == edge.r2 && edge.p1 + 1 == edge.p2;
+      edges.push_back(edge);
+    }
+    tokenizer.nextLine();
+  }
+  return true;
+}
+
+std::vector<PoseEdge> poseEdges(const std::vector<DatasetEdge> &edges) {
+  std::vector<PoseEdge> pose_edges;
+  pose_edges.reserve(edges.size());
+  for (const auto &edge : edges) pose_edges.emplace_back(edge.p1, edge.p2);
+  return pose_edges;
+}
+
+std::vector<std::vector<DatasetEdge>> splitDatasetEdges(
+    const std::vector<DatasetEdge> &edges,
+    const std::vector<PoseID> &assignment,
+    unsigned num_robots) {
+  std::vector<std::vector<DatasetEdge>> odometry(num_robots);
+  std::vector<std::vector<DatasetEdge>> private_loop_closures(num_robots);
+  std::vector<std::vector<DatasetEdge>> shared_loop_closures(num_robots);
+  for (const auto &edgeIn : edges) {
+    const PoseID &src = assignment.at(edgeIn.p1);
+    const PoseID &dst = assignment.at(edgeIn.p2);
+    DatasetEdge edge = edgeIn;
+    edge.r1 = src.robot_id;
+    edge.r2 = dst.robot_id;
+    edge.p1 = src.frame_id;
+    edge.p2 = dst.frame_id;
+    edge.odometry = src.robot_id == dst.robot_id && edgeIn.p1 + 1 == edgeIn.p2;
+    if (src.robot_id != dst.robot_id) {
+      shared_loop_closures.at(src.robot_id).push_back(edge);
+    } else if (edge.odometry) {
+      odometry.at(src.robot_id).push_back(edge);
+    } else {
+      private_loop_closures.at(src.robot_id).push_back(edge);
+    }
+  }
+
+  std::vector<std::vector<DatasetEdge>> robot_edges(num_robots);
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    auto &result = robot_edges[robot];
+    result.swap(odometry[robot]);
+    result.insert(result.end(),
+                  private_loop_closures[robot].begin(),
+                  private_loop_closures[robot].end());
+    result.insert(result.end(),
+                  shared_loop_closures[robot].begin(),
+                  shared_loop_closures[robot].end());
+  }
+  return robot_edges;
+}
+
+pose_graph_tools_msgs::PoseGraphEdge DatasetEdgeToMsg(const DatasetEdge &edge) {
+  pose_graph_tools_msgs::PoseGraphEdge msg;
+  msg.robot_from = edge.r1;
+  msg.robot_to = edge.r2;
+  msg.key_from = edge.p1;
+  msg.key_to = edge.p2;
+  msg.pose.orientation.x = edge.quaternion[0];
+  msg.pose.orientation.y = edge.quaternion[1];
+  msg.pose.orientation.z = edge.quaternion[2];
+  msg.pose.orientation.w = edge.quaternion[3];
+  msg.pose.position.x = edge.translation[0];
+  msg.pose.position.y = edge.translation[1];
+  msg.pose.position.z = edge.translation[2];
+  WeightsToCovariance(edge.kappa, edge.tau, msg.covariance.data());
+  return msg;
+}
+
+RelativeSEMeasurement DatasetEdgeToMeasurement(const DatasetEdge &edge) {
+  const Eigen::Quaterniond q(
+      edge.quaternion[3], edge.quaternion[0], edge.quaternion[1], edge.quaternion[2]);
+  const Matrix R = q.toRotationMatrix();
+  Matrix t(3, 1);
+  t << edge.translation[0], edge.translation[1], edge.translation[2];
+  return RelativeSEMeasurement(
+      edge.r1, edge.r2, edge.p1, edge.p2, R, t, edge.kappa, edge.tau);
+}
+
+std::string datasetCacheKey(const std::string &filename,
+                            unsigned num_robots,
+                            const std::string &partition_method,
+                            double partition_imbalance) {
+  std::error_code ec;
+  const auto path = std::filesystem::canonical(filename, ec);
+  if (ec) return "";
+  const auto size = std::filesystem::file_size(path, ec);
+  if (ec) return "";
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) return "";
+  return path.string() + "|" + std::to_string(size) + "|" +
+         std::to_string(mtime.time_since_epoch().count()) + "|" +
+         std::to_string(num_robots) + "|" + partition_method + "|" +
+         std::to_string(partition_imbalance);
+}
+
+std::string datasetCacheFile(const std::string &cache_directory,
+                             const std::string &filename,
+                             const std::string &key) {
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)hashKey(key));
+  const std::string stem = std::filesystem::path(filename).stem().string();
+  return (std::filesystem::path(cache_directory) / (stem + "_" + hash + ".bin"))
+      .string();
+}
+
+bool writeDatasetCache(const std::string &cache_file,
+                       const std::string &key,
+                       size_t num_poses,
+                       const std::vector<std::vector<DatasetEdge>> &robot_edges) {
+  std::error_code ec;
+  const auto directory = std::filesystem::path(cache_file).parent_path();
+  if (!directory.empty()) std::filesystem::create_directories(directory, ec);
+  if (ec) return false;
+
+  const std::string tmp_file = cache_file + ".tmp" + std::to_string(::getpid());
+  FILE *file = std::fopen(tmp_file.c_str(), "wb");
+  if (!file) return false;
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.recordSize = sizeof(DatasetEdge);
+  header.numRobots = robot_edges.size();
+  header.numPoses = num_poses;
+  header.keyLength = key.size();
+  std::vector<char> padded_key(paddedKeyLength(key.size()), '\0');
+  std::copy(key.begin(), key.end(), padded_key.begin());
+  std::vector<uint64_t> num_edges;
+  for (const auto &edges : robot_edges) num_edges.push_back(edges.size());
+
+  bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  success &= std::fwrite(padded_key.data(), 1, padded_key.size(), file) ==
+             padded_key.size();
+  success &= std::fwrite(num_edges.data(), sizeof(uint64_t), num_edges.size(), file) ==
+             num_edges.size();
+  for (const auto &edges : robot_edges) {
+    success &= std::fwrite(edges.data(), sizeof(DatasetEdge), edges.size(), file) ==
+               edges.size();
+  }
+  success &= std::fclose(file) == 0;
+  if (success) success = std::rename(tmp_file.c_str(), cache_file.c_str()) == 0;
+  if (!success) std::remove(tmp_file.c_str());
+  return success;
+}
+
+bool readDatasetCache(const std::string &cache_file,
+                      const std::string &key,
+                      size_t &num_poses,
+                      std::vector<std::vector<DatasetEdge>> &robot_edges) {
+  const MappedFile file(cache_file);
+  if (!file.data() || file.size() < sizeof(CacheHeader)) return false;
+
+  CacheHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion || header.recordSize != sizeof(DatasetEdge) ||
+      header.keyLength != key.size()) {
+    return false;
+  }
+  size_t offset = sizeof(header);
+  if (file.size() - offset < paddedKeyLength(key.size()) ||
+      key.compare(0, key.size(), file.data() + offset, key.size()) != 0) {
+    return false;
+  }
+  offset += paddedKeyLength(key.size());
+  if ((file.size() - offset) / sizeof(uint64_t) < header.numRobots) return false;
+  std::vector<uint64_t> num_edges(header.numRobots);
+  std::memcpy(
+      num_edges.data(), file.data() + offset, header.numRobots * sizeof(uint64_t));
+  offset += header.numRobots * sizeof(uint64_t);
+
+  robot_edges.assign(header.numRobots, {});
+  for (size_t robot = 0; robot < header.numRobots; ++robot) {
+    if ((file.size() - offset) / sizeof(DatasetEdge) < num_edges[robot]) return false;
+    robot_edges[robot].resize(num_edges[robot]);
+    std::memcpy(robot_edges[robot].data(),
+                file.data() + offset,
+                num_edges[robot] * sizeof(DatasetEdge));
+    offset += num_edges[robot] * sizeof(DatasetEdge);
+  }
+  num_poses = header.numPoses;
+  return offset == file.size();
+}
+
+}  // namespace dpgo_ros
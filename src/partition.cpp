@@ -0,0 +1,494 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <dpgo_ros/partition.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+
+namespace dpgo_ros {
+
+namespace {
+
+// Undirected graph with vertex and edge weights
+struct WeightedGraph {
+  std::vector<int> vertexWeights;
+  std::vector<std::vector<std::pair<unsigned, int>>> adjacency;
+
+  size_t size() const { return vertexWeights.size(); }
+
+  int totalWeight() const {
+    return std::accumulate(vertexWeights.begin(), vertexWeights.end(), 0);
+  }
+};
+
+WeightedGraph buildGraph(const std::vector<int> &vertex_weights,
+                         const std::vector<std::map<unsigned, int>> &edges) {
+  WeightedGraph graph;
+  graph.vertexWeights = vertex_weights;
+  graph.adjacency.resize(vertex_weights.size());
+  for (size_t v = 0; v < edges.size(); ++v) {
+    graph.adjacency[v].assign(edges[v].begin(), edges[v].end());
+  }
+  return graph;
+}
+
+// Each pose is a vertex, and parallel measurements are merged into a single edge
+WeightedGraph buildPoseGraph(size_t num_poses,
+                             const std::vector<PoseEdge> &pose_edges) {
+  std::vector<std::map<unsigned, int>> edges(num_poses);
+  for (const auto &[p1, p2] : pose_edges) {
+    if (p1 == p2 || p1 >= num_poses || p2 >= num_poses) continue;
+    edges[p1][p2]++;
+    edges[p2][p1]++;
+  }
+  return buildGraph(std::vector<int>(num_poses, 1), edges);
+}
+
+// Match each vertex with the unmatched neighbor connected by the heaviest edge.
+// Return the number of coarse vertices, and the coarse vertex of each vertex.
+unsigned matchHeavyEdges(const WeightedGraph &graph,
+                         int max_vertex_weight,
+                         std::vector<unsigned> &coarse_map) {
+  const size_t n = graph.size();
+  const unsigned unmatched = std::numeric_limits<unsigned>::max();
+  // Visit vertices with fewer neighbors first, as they have fewer options to match
+  std::vector<unsigned> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+    return graph.adjacency[a].size() < graph.adjacency[b].size();
+  });
+
+  std::vector<unsigned> match(n, unmatched);
+  for (unsigned v : order) {
+    if (match[v] != unmatched) continue;
+    unsigned best = v;
+    int best_weight = 0;
+    for (const auto &[u, w] : graph.adjacency[v]) {
+      if (match[u] != unmatched || w <= best_weight) continue;
+      if (graph.vertexWeights[v] + graph.vertexWeights[u] > max_vertex_weight) continue;
+      best = u;
+      best_weight = w;
+    }
+    match[v] = best;
+    match[best] = v;
+  }
+
+  coarse_map.assign(n, unmatched);
+  unsigned num_coarse = 0;
+  for (unsigned v = 0; v < n; ++v) {
+    if (coarse_map[v] != unmatched) continue;
+    coarse_map[v] = num_coarse;
+    coarse_map[match[v]] = num_coarse;
+    num_coarse++;
+  }
+  return num_coarse;
+}
+
+WeightedGraph contractGraph(const WeightedGraph &graph,
+                            const std::vector<unsigned> &coarse_map,
+                            unsigned num_coarse) {
+  std::vector<int> vertex_weights(num_coarse, 0);
+  std::vector<std::map<unsigned, int>> edges(num_coarse);
+  for (unsigned v = 0; v < graph.size(); ++v) {
+    const unsigned cv = coarse_map[v];
+    vertex_weights[cv] += graph.vertexWeights[v];
+    for (const auto &[u, w] : graph.adjacency[v]) {
+      const unsigned cu = coarse_map[u];
+      if (cu != cv) edges[cv][cu] += w;
+    }
+  }
+  return buildGraph(vertex_weights, edges);
+}
+
+// Total weight of the edges between different parts
+int computeCut(const WeightedGraph &graph, const std::vector<unsigned> &parts) {
+  int cut = 0;
+  for (unsigned v = 0; v < graph.size(); ++v) {
+    for (const auto &[u, w] : graph.adjacency[v]) {
+      if (v < u && parts[u] != parts[v]) cut += w;
+    }
+  }
+  return cut;
+}
+
+// Grow each part from a seed vertex by repeatedly adding the unassigned vertex with
+// the strongest connection to the part, until the part reaches its target weight.
+// Seeds are the first unassigned vertices starting from first_seed.
+std::vector<unsigned> growPartition(const WeightedGraph &graph,
+                                    unsigned num_parts,
+                                    unsigned first_seed) {
+  const size_t n = graph.size();
+  const unsigned unassigned = num_parts;
+  std::vector<unsigned> parts(n, unassigned);
+  int remaining_weight = graph.totalWeight();
+  size_t num_seeds_visited = 0;
+  for (unsigned p = 0; p + 1 < num_parts; ++p) {
+    const double target_weight = (double)remaining_weight / (num_parts - p);
+    int weight = 0;
+    std::vector<int> connection(n, 0);
+    std::set<std::pair<int, unsigned>> frontier;  // (-connection, vertex)
+    while (weight < target_weight) {
+      unsigned v;
+      if (frontier.empty()) {
+        while (num_seeds_visited < n &&
+               parts[(first_seed + num_seeds_visited) % n] != unassigned) {
+          num_seeds_visited++;
+        }
+        if (num_seeds_visited == n) break;
+        v = (first_seed + num_seeds_visited) % n;
+      } else {
+        v = frontier.begin()->second;
+        frontier.erase(frontier.begin());
+      }
+      parts[v] = p;
+      weight += graph.vertexWeights[v];
+      for (const auto &[u, w] : graph.adjacency[v]) {
+        if (parts[u] != unassigned) continue;
+        frontier.erase(std::make_pair(-connection[u], u));
+        connection[u] += w;
+        frontier.emplace(-connection[u], u);
+      }
+    }
+    remaining_weight -= weight;
+  }
+  for (auto &part : parts) {
+    if (part == unassigned) part = num_parts - 1;
+  }
+  return parts;
+}
+
+// Return true if moving v to another part provably keeps its part connected, i.e., if
+// all neighbors of v in the same part are connected without v. The search is limited
+// to a small neighborhood, so false negatives are possible.
+bool isSafeToMove(const WeightedGraph &graph,
+                  const std::vector<unsigned> &parts,
+                  unsigned v) {
+  const size_t max_visited = 64;
+  std::set<unsigned> targets;
+  for (const auto &neighbor : graph.adjacency[v]) {
+    if (parts[neighbor.first] == parts[v]) targets.insert(neighbor.first);
+  }
+  if (targets.size() <= 1) return true;
+  std::set<unsigned> visited = {v, *targets.begin()};
+  std::vector<unsigned> queue = {*targets.begin()};
+  size_t num_found = 1;
+  for (size_t i = 0; i < queue.size() && visited.size() < max_visited; ++i) {
+    for (const auto &neighbor : graph.adjacency[queue[i]]) {
+      const unsigned u = neighbor.first;
+      if (parts[u] != parts[v] || !visited.insert(u).second) continue;
+      if (targets.count(u) && ++num_found == targets.size()) return true;
+      queue.push_back(u);
+    }
+  }
+  return false;
+}
+
+// Greedy boundary refinement. A vertex moves to the neighboring part that reduces the
+// cut the most, as long as the balance constraint holds and its part stays connected.
+// Vertices of overweight parts move even if the cut increases, and moves that do not
+// change the cut are accepted if they improve the balance.
+void refinePartition(const WeightedGraph &graph,
+                     unsigned num_parts,
+                     double imbalance,
+                     std::vector<unsigned> &parts) {
+  const double average_weight = (double)graph.totalWeight() / num_parts;
+  const int max_weight = (int)std::ceil((1 + imbalance) * average_weight);
+  const int min_weight = (int)std::floor((1 - imbalance) * average_weight);
+  std::vector<int> part_weights(num_parts, 0);
+  for (unsigned v = 0; v < graph.size(); ++v) {
+    part_weights[parts[v]] += graph.vertexWeights[v];
+  }
+
+  const int max_passes = 10;
+  std::vector<int> connection(num_parts);
+  for (int pass = 0; pass < max_passes; ++pass) {
+    size_t num_moves = 0;
+    for (unsigned v = 0; v < graph.size(); ++v) {
+      const unsigned p = parts[v];
+      const int vertex_weight = graph.vertexWeights[v];
+      std::fill(connection.begin(), connection.end(), 0);
+      bool boundary = false;
+      for (const auto &[u, w] : graph.adjacency[v]) {
+        connection[parts[u]] += w;
+        if (parts[u] != p) boundary = true;
+      }
+      if (!boundary) continue;
+      const bool overweight = part_weights[p] > max_weight;
+      if (!overweight && part_weights[p] - vertex_weight < min_weight) continue;
+
+      unsigned best = p;
+      int best_gain = overweight ? std::numeric_limits<int>::min() : 0;
+      for (unsigned q = 0; q < num_parts; ++q) {
+        if (q == p || connection[q] == 0) continue;
+        if (part_weights[q] + vertex_weight > max_weight) continue;
+        const int gain = connection[q] - connection[p];
+        bool better = gain > best_gain;
+        if (gain == best_gain) {
+          better = best == p ? part_weights[q] + vertex_weight < part_weights[p]
+                             : part_weights[q] < part_weights[best];
+        }
+        if (better) {
+          best = q;
+          best_gain = gain;
+        }
+      }
+      if (best == p || !isSafeToMove(graph, parts, v)) continue;
+      parts[v] = best;
+      part_weights[p] -= vertex_weight;
+      part_weights[best] += vertex_weight;
+      num_moves++;
+    }
+    if (num_moves == 0) break;
+  }
+}
+
+// Partition the coarsest graph. Graph growing is sensitive to the seed, so several
+// seeds are tried and the partition with the smallest cut after refinement is kept.
+std::vector<unsigned> initialPartition(const WeightedGraph &graph,
+                                       unsigned num_parts,
+                                       double imbalance) {
+  const unsigned num_trials = std::min<size_t>(8, graph.size());
+  std::vector<unsigned> best_parts;
+  int best_cut = std::numeric_limits<int>::max();
+  for (unsigned trial = 0; trial < num_trials; ++trial) {
+    auto parts = growPartition(graph, num_parts, trial * graph.size() / num_trials);
+    refinePartition(graph, num_parts, imbalance, parts);
+    const int cut = computeCut(graph, parts);
+    if (cut < best_cut) {
+      best_cut = cut;
+      best_parts.swap(parts);
+    }
+  }
+  return best_parts;
+}
+
+// Move connected components that are not the largest component of their part to the
+// neighboring part with the strongest connection. This may violate the balance
+// constraint.
+void connectParts(const WeightedGraph &graph,
+                  unsigned num_parts,
+                  std::vector<unsigned> &parts) {
+  const size_t n = graph.size();
+  const int max_rounds = 10;
+  for (int round = 0; round < max_rounds; ++round) {
+    std::vector<int> component(n, -1);
+    std::vector<std::vector<unsigned>> components;
+    for (unsigned seed = 0; seed < n; ++seed) {
+      if (component[seed] >= 0) continue;
+      const int c = components.size();
+      components.emplace_back(1, seed);
+      component[seed] = c;
+      for (size_t i = 0; i < components[c].size(); ++i) {
+        const unsigned v = components[c][i];
+        for (const auto &neighbor : graph.adjacency[v]) {
+          const unsigned u = neighbor.first;
+          if (component[u] >= 0 || parts[u] != parts[seed]) continue;
+          component[u] = c;
+          components[c].push_back(u);
+        }
+      }
+    }
+
+    std::vector<int> largest(num_parts, -1);
+    for (size_t c = 0; c < components.size(); ++c) {
+      const unsigned p = parts[components[c][0]];
+      if (largest[p] < 0 || components[c].size() > components[largest[p]].size()) {
+        largest[p] = c;
+      }
+    }
+
+    bool changed = false;
+    std::vector<int> connection(num_parts);
+    for (size_t c = 0; c < components.size(); ++c) {
+      const unsigned p = parts[components[c][0]];
+      if ((int)c == largest[p]) continue;
+      std::fill(connection.begin(), connection.end(), 0);
+      for (unsigned v : components[c]) {
+        for (const auto &[u, w] : graph.adjacency[v]) {
+          if (parts[u] != p) connection[parts[u]] += w;
+        }
+      }
+      const auto best = std::max_element(connection.begin(), connection.end());
+      // Component is disconnected from the rest of the pose graph
+      if (*best == 0) continue;
+      for (unsigned v : components[c]) {
+        parts[v] = std::distance(connection.begin(), best);
+      }
+      changed = true;
+    }
+    if (!changed) break;
+  }
+}
+
+// Restore the balance constraint after connectParts by moving boundary vertices out of
+// overweight parts or into underweight parts, without disconnecting any part
+void balanceParts(const WeightedGraph &graph,
+                  unsigned num_parts,
+                  double imbalance,
+                  std::vector<unsigned> &parts) {
+  const double average_weight = (double)graph.totalWeight() / num_parts;
+  const int max_weight = (int)std::ceil((1 + imbalance) * average_weight);
+  const int min_weight = (int)std::floor((1 - imbalance) * average_weight);
+  std::vector<int> part_weights(num_parts, 0);
+  for (unsigned v = 0; v < graph.size(); ++v) {
+    part_weights[parts[v]] += graph.vertexWeights[v];
+  }
+
+  const size_t max_passes = graph.size();
+  std::vector<int> connection(num_parts);
+  for (size_t pass = 0; pass < max_passes; ++pass) {
+    bool balanced = true;
+    for (int weight : part_weights) {
+      if (weight > max_weight || weight < min_weight) balanced = false;
+    }
+    if (balanced) return;
+
+    size_t num_moves = 0;
+    for (unsigned v = 0; v < graph.size(); ++v) {
+      const unsigned p = parts[v];
+      const int vertex_weight = graph.vertexWeights[v];
+      const bool overweight = part_weights[p] > max_weight;
+      if (!overweight && part_weights[p] - vertex_weight < min_weight) continue;
+      std::fill(connection.begin(), connection.end(), 0);
+      for (const auto &[u, w] : graph.adjacency[v]) connection[parts[u]] += w;
+
+      unsigned best = p;
+      int best_gain = std::numeric_limits<int>::min();
+      for (unsigned q = 0; q < num_parts; ++q) {
+        if (q == p || connection[q] == 0) continue;
+        if (!overweight && part_weights[q] >= min_weight) continue;
+        if (part_weights[q] + vertex_weight > max_weight) continue;
+        const int gain = connection[q] - connection[p];
+        if (gain > best_gain) {
+          best = q;
+          best_gain = gain;
+        }
+      }
+      if (best == p || !isSafeToMove(graph, parts, v)) continue;
+      parts[v] = best;
+      part_weights[p] -= vertex_weight;
+      part_weights[best] += vertex_weight;
+      num_moves++;
+    }
+    if (num_moves == 0) return;
+  }
+}
+
+}  // namespace
+
+std::vector<PoseEdge> poseEdges(
+    const std::vector<RelativeSEMeasurement> &measurements) {
+  std::vector<PoseEdge> edges;
+  edges.reserve(measurements.size());
+  for (const auto &m : measurements) edges.emplace_back(m.p1, m.p2);
+  return edges;
+}
+
+std::vector<unsigned> partitionPoseGraph(size_t num_poses,
+                                         const std::vector<PoseEdge> &edges,
+                                         unsigned num_parts,
+                                         double imbalance) {
+  if (num_parts == 0 || num_poses < num_parts) return {};
+  if (num_parts == 1) return std::vector<unsigned>(num_poses, 0);
+
+  // Coarsening
+  const size_t coarsest_size = std::max<size_t>(20 * num_parts, 100);
+  const int max_vertex_weight = std::max<int>(1, num_poses / (4 * num_parts));
+  std::vector<WeightedGraph> levels;
+  std::vector<std::vector<unsigned>> coarse_maps;
+  levels.push_back(buildPoseGraph(num_poses, edges));
+  while (levels.back().size() > coarsest_size) {
+    std::vector<unsigned> coarse_map;
+    unsigned num_coarse = matchHeavyEdges(levels.back(), max_vertex_weight, coarse_map);
+    // Stop when matching no longer reduces the graph
+    if (num_coarse > 0.95 * levels.back().size()) break;
+    WeightedGraph coarse = contractGraph(levels.back(), coarse_map, num_coarse);
+    levels.push_back(std::move(coarse));
+    coarse_maps.push_back(std::move(coarse_map));
+  }
+
+  // Initial partition of the coarsest graph
+  std::vector<unsigned> parts = initialPartition(levels.back(), num_parts, imbalance);
+  connectParts(levels.back(), num_parts, parts);
+  balanceParts(levels.back(), num_parts, imbalance, parts);
+
+  // Uncoarsening
+  for (size_t level = coarse_maps.size(); level-- > 0;) {
+    std::vector<unsigned> finer_parts(levels[level].size());
+    for (unsigned v = 0; v < finer_parts.size(); ++v) {
+      finer_parts[v] = parts[coarse_maps[level][v]];
+    }
+    parts.swap(finer_parts);
+    refinePartition(levels[level], num_parts, imbalance, parts);
+  }
+
+  // Parts are connected at the coarsest level, and refinement keeps them connected
+  // unless the neighborhood search of isSafeToMove is inconclusive
+  connectParts(levels.front(), num_parts, parts);
+  balanceParts(levels.front(), num_parts, imbalance, parts);
+  return parts;
+}
+
+std::vector<unsigned> partitionPoseGraph(
+    size_t num_poses,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_parts,
+    double imbalance) {
+  return partitionPoseGraph(num_poses, poseEdges(measurements), num_parts, imbalance);
+}
+
+std::vector<PoseID> minCutPoseAssignment(size_t num_poses,
+                                         const std::vector<PoseEdge> &edges,
+                                         unsigned num_robots,
+                                         double imbalance) {
+  std::vector<PoseID> assignment;
+  const auto parts = partitionPoseGraph(num_poses, edges, num_robots, imbalance);
+  if (parts.empty()) return assignment;
+  std::vector<unsigned> num_robot_poses(num_robots, 0);
+  assignment.reserve(num_poses);
+  for (unsigned robot : parts) {
+    assignment.emplace_back(robot, num_robot_poses[robot]++);
+  }
+  return assignment;
+}
+
+std::vector<PoseID> minCutPoseAssignment(
+    size_t num_poses,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_robots,
+    double imbalance) {
+  return minCutPoseAssignment(
+      num_poses, poseEdges(measurements), num_robots, imbalance);
+}
+
+std::vector<size_t> computeEdgeCuts(const std::vector<PoseID> &assignment,
+                                    const std::vector<PoseEdge> &edges,
+                                    unsigned num_robots) {
+  std::vector<size_t> cuts(num_robots, 0);
+  for (const auto &[p1, p2] : edges) {
+    const unsigned src_robot = assignment.at(p1).robot_id;
+    const unsigned dst_robot = assignment.at(p2).robot_id;
+    if (src_robot == dst_robot) continue;
+    cuts.at(src_robot)++;
+    cuts.at(dst_robot)++;
+  }
+  return cuts;
+}
+
+std::vector<size_t> computeEdgeCuts(
+    const std::vector<PoseID> &assignment,
+    const std::vector<RelativeSEMeasurement> &measurements,
+    unsigned num_robots) {
+  return computeEdgeCuts(assignment, poseEdges(measurements), num_robots);
+}
+
+}  // namespace dpgo_ros
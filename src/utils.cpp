@@ -8,9 +8,14 @@
 #include <DPGO/DPGO_types.h>
 #include <DPGO/DPGO_utils.h>
 #include <dpgo_ros/utils.h>
-#include <tf/tf.h>
+#include <ros/serialization.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <numeric>
 #include <random>
 
 using namespace DPGO;
@@ -59,144 +64,291 @@ Matrix MatrixFromMsg(const MatrixMsg &msg) {
   return deserializeMatrix(msg.rows, msg.cols, msg.values);
 }
 
-Matrix RotationFromPoseMsg(const geometry_msgs::Pose &msg) {
-  // read rotation
-  tf::Quaternion quat;
-  tf::quaternionMsgToTF(msg.orientation, quat);
-  tf::Matrix3x3 rotation(quat);
-  Matrix R(3, 3);
-  R << rotation[0][0], rotation[0][1], rotation[0][2], rotation[1][0], rotation[1][1],
-      rotation[1][2], rotation[2][0], rotation[2][1], rotation[2][2];
+namespace {
+
+// Weights of measurements received without covariance
+constexpr double kDefaultKappa = 10000;
+constexpr double kDefaultTau = 100;
+
+Eigen::Quaterniond QuaternionFromMsg(const geometry_msgs::Quaternion &msg) {
+  return Eigen::Quaterniond(msg.w, msg.x, msg.y, msg.z).normalized();
+}
+
+void QuaternionToMsg(const Eigen::Quaterniond &q, geometry_msgs::Quaternion &msg) {
+  msg.x = q.x();
+  msg.y = q.y();
+  msg.z = q.z();
+  msg.w = q.w();
+}
+
+// Convert pose i of the aggregate matrix T. Each pose [R t] is a contiguous block of
+// the column-major matrix T, so the rotation and translation are read in place.
+void TrajectoryPoseToMsg(unsigned d,
+                         const Matrix &T,
+                         size_t i,
+                         geometry_msgs::Pose &pose) {
+  const double *pose_data = T.data() + i * d * (d + 1);
+  const Eigen::Quaterniond q(Eigen::Map<const Eigen::Matrix3d>(pose_data).eval());
+  QuaternionToMsg(q, pose.orientation);
+  pose.position.x = pose_data[d * d];
+  pose.position.y = pose_data[d * d + 1];
+  pose.position.z = pose_data[d * d + 2];
+}
 
-  return R;
+}  // namespace
+
+Matrix RotationFromPoseMsg(const geometry_msgs::Pose &msg) {
+  return QuaternionFromMsg(msg.orientation).toRotationMatrix();
 }
 
 Matrix TranslationFromPoseMsg(const geometry_msgs::Pose &msg) {
-  tf::Vector3 translation;
-  tf::pointMsgToTF(msg.position, translation);
-  Matrix t(3, 1);
-  t << translation.x(), translation.y(), translation.z();
-  return t;
+  return Eigen::Vector3d(msg.position.x, msg.position.y, msg.position.z);
 }
 
 geometry_msgs::Quaternion RotationToQuaternionMsg(const Matrix &R) {
   assert(R.rows() == 3);
   assert(R.cols() == 3);
-
-  tf::Matrix3x3 rotation(
-      R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2), R(2, 0), R(2, 1), R(2, 2));
-  tf::Quaternion quat;
-  rotation.getRotation(quat);
   geometry_msgs::Quaternion quat_msg;
-  tf::quaternionTFToMsg(quat, quat_msg);
+  QuaternionToMsg(Eigen::Quaterniond(Eigen::Matrix3d(R)), quat_msg);
   return quat_msg;
 }
 
 geometry_msgs::Point TranslationToPointMsg(const Matrix &t) {
   assert(t.rows() == 3);
   assert(t.cols() == 1);
-  // convert translation to ROS message
-  tf::Vector3 translation(t(0), t(1), t(2));
   geometry_msgs::Point point_msg;
-  tf::pointTFToMsg(translation, point_msg);
+  point_msg.x = t(0);
+  point_msg.y = t(1);
+  point_msg.z = t(2);
   return point_msg;
 }
 
-PoseGraphEdge RelativeMeasurementToMsg(const RelativeSEMeasurement &m) {
+void WeightsToCovariance(double kappa, double tau, double *covariance) {
+  std::fill(covariance, covariance + 36, 0.0);
+  if (!(kappa > 0) || !(tau > 0)) return;
+  for (size_t i = 0; i < 3; ++i) {
+    covariance[i * 7] = 1 / tau;
+    covariance[(i + 3) * 7] = 1 / (2 * kappa);
+  }
+}
+
+bool WeightsFromCovariance(const double *covariance, double &kappa, double &tau) {
+  // Only the traces of the translation and rotation blocks are needed
+  const double tran_trace = covariance[0] + covariance[7] + covariance[14];
+  const double rot_trace = covariance[21] + covariance[28] + covariance[35];
+  if (!(tran_trace > 0) || !(rot_trace > 0) || !std::isfinite(tran_trace) ||
+      !std::isfinite(rot_trace)) {
+    kappa = kDefaultKappa;
+    tau = kDefaultTau;
+    return false;
+  }
+  tau = 3 / tran_trace;
+  kappa = 3 / (2 * rot_trace);
+  return true;
+}
+
+void RelativeMeasurementToMsg(const RelativeSEMeasurement &m, PoseGraphEdge &msg) {
   assert(m.R.rows() == 3 && m.R.cols() == 3);
   assert(m.t.rows() == 3 && m.t.cols() == 1);
 
-  PoseGraphEdge msg;
   msg.robot_from = m.r1;
   msg.robot_to = m.r2;
   msg.key_from = m.p1;
   msg.key_to = m.p2;
 
-  // convert rotation to ROS message
-  msg.pose.orientation = RotationToQuaternionMsg(m.R);
-
-  // convert translation to ROS message
-  msg.pose.position = TranslationToPointMsg(m.t);
+  // Fixed-size copies avoid heap allocations
+  const Eigen::Matrix3d R = m.R;
+  QuaternionToMsg(Eigen::Quaterniond(R), msg.pose.orientation);
+  msg.pose.position.x = m.t(0);
+  msg.pose.position.y = m.t(1);
+  msg.pose.position.z = m.t(2);
+  WeightsToCovariance(m.kappa, m.tau, msg.covariance.data());
+}
 
-  // TODO: write covariance to message
+PoseGraphEdge RelativeMeasurementToMsg(const RelativeSEMeasurement &m) {
+  PoseGraphEdge msg;
+  RelativeMeasurementToMsg(m, msg);
   return msg;
 }
 
+void RelativeMeasurementFromMsg(const PoseGraphEdge &msg, RelativeSEMeasurement &m) {
+  m.r1 = msg.robot_from;
+  m.r2 = msg.robot_to;
+  m.p1 = msg.key_from;
+  m.p2 = msg.key_to;
+
+  // Assignments reuse the storage of m when it already has the right size
+  m.R = QuaternionFromMsg(msg.pose.orientation).toRotationMatrix();
+  m.t = Eigen::Vector3d(msg.pose.position.x, msg.pose.position.y, msg.pose.position.z);
+  WeightsFromCovariance(msg.covariance.data(), m.kappa, m.tau);
+
+  // By default, odometry edge is inlier
+  m.weight = 1;
+  m.fixedWeight = m.r1 == m.r2 && m.p1 + 1 == m.p2;
+}
+
 RelativeSEMeasurement RelativeMeasurementFromMsg(const PoseGraphEdge &msg) {
-  size_t r1 = msg.robot_from;
-  size_t r2 = msg.robot_to;
-  size_t p1 = msg.key_from;
-  size_t p2 = msg.key_to;
+  RelativeSEMeasurement m(0,
+                          0,
+                          0,
+                          0,
+                          Matrix::Identity(3, 3),
+                          Matrix::Zero(3, 1),
+                          kDefaultKappa,
+                          kDefaultTau);
+  RelativeMeasurementFromMsg(msg, m);
+  return m;
+}
 
-  // read rotation
-  Matrix R = RotationFromPoseMsg(msg.pose);
+void RelativeMeasurementsFromMsgs(const std::vector<PoseGraphEdge> &msgs,
+                                  std::vector<RelativeSEMeasurement> &measurements) {
+  if (measurements.size() != msgs.size()) {
+    // New measurements are allocated once with the final matrix sizes
+    measurements.resize(msgs.size(),
+                        RelativeSEMeasurement(0,
+                                              0,
+                                              0,
+                                              0,
+                                              Matrix::Identity(3, 3),
+                                              Matrix::Zero(3, 1),
+                                              kDefaultKappa,
+                                              kDefaultTau));
+  }
+  for (size_t k = 0; k < msgs.size(); ++k) {
+    RelativeMeasurementFromMsg(msgs[k], measurements[k]);
+  }
+}
 
-  // read translation
-  Matrix t = TranslationFromPoseMsg(msg.pose);
+void RelativeMeasurementsToMsgs(const std::vector<RelativeSEMeasurement> &measurements,
+                                std::vector<PoseGraphEdge> &msgs) {
+  msgs.resize(measurements.size());
+  for (size_t k = 0; k < measurements.size(); ++k) {
+    RelativeMeasurementToMsg(measurements[k], msgs[k]);
+  }
+}
 
-  // TODO: read covariance from message
-  double kappa = 10000;
-  double tau = 100;
+void TrajectoryToPoses(unsigned d,
+                       unsigned n,
+                       const Matrix &T,
+                       std::vector<geometry_msgs::Pose> &poses) {
+  assert(d == 3);
+  assert(T.rows() == d);
+  assert(T.cols() == (d + 1) * n);
+  poses.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    TrajectoryPoseToMsg(d, T, i, poses[i]);
+  }
+}
 
-  RelativeSEMeasurement m(r1, r2, p1, p2, R, t, kappa, tau);
+std::vector<unsigned> TrajectoryKeyframes(unsigned d,
+                                          unsigned n,
+                                          const Matrix &T,
+                                          double min_distance,
+                                          double min_angle) {
+  assert(d == 3);
+  assert(T.rows() == d);
+  assert(T.cols() == (d + 1) * n);
+  std::vector<unsigned> keys;
+  if (n == 0) return keys;
+  const bool use_distance = min_distance > 0;
+  const bool use_angle = min_angle > 0;
+  if (!use_distance && !use_angle) {
+    keys.resize(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    return keys;
+  }
+  // Compare squared distance and the cosine of the angle to avoid sqrt and acos
+  const double min_distance_squared = min_distance * min_distance;
+  const double max_trace = 1 + 2 * std::cos(std::min(min_angle, M_PI));
+  const size_t stride = d * (d + 1);
+  keys.push_back(0);
+  for (unsigned i = 1; i < n; ++i) {
+    const double *last = T.data() + keys.back() * stride;
+    const double *current = T.data() + i * stride;
+    const Eigen::Map<const Eigen::Matrix3d> R_last(last);
+    const Eigen::Map<const Eigen::Matrix3d> R_current(current);
+    const Eigen::Map<const Eigen::Vector3d> t_last(last + d * d);
+    const Eigen::Map<const Eigen::Vector3d> t_current(current + d * d);
+    // trace(R_last^T R_current) = 1 + 2 cos(angle)
+    const bool moved =
+        use_distance && (t_current - t_last).squaredNorm() > min_distance_squared;
+    const bool rotated =
+        use_angle && R_last.cwiseProduct(R_current).sum() < max_trace;
+    if (moved || rotated || i + 1 == n) keys.push_back(i);
+  }
+  return keys;
+}
 
-  // By default, odometry edge is inlier
-  if (r1 == r2 && p1 + 1 == p2) {
-    m.fixedWeight = true;
+void TrajectoryToMsgs(unsigned robotID,
+                      unsigned d,
+                      unsigned n,
+                      const Matrix &T,
+                      const std::vector<unsigned> &keys,
+                      geometry_msgs::PoseArray &pose_array,
+                      nav_msgs::Path &path,
+                      pose_graph_tools_msgs::PoseGraph &pose_graph) {
+  assert(d == 3);
+  assert(T.rows() == d);
+  assert(T.cols() == (d + 1) * n);
+  const ros::Time stamp = ros::Time::now();
+  pose_array.header.frame_id = "/world";
+  pose_array.header.stamp = stamp;
+  path.header = pose_array.header;
+  pose_graph.header = pose_array.header;
+
+  const size_t num_keys = keys.size();
+  pose_array.poses.resize(num_keys);
+  path.poses.resize(num_keys);
+  pose_graph.nodes.resize(num_keys);
+  for (size_t k = 0; k < num_keys; ++k) {
+    assert(keys[k] < n);
+    auto &pose = pose_array.poses[k];
+    TrajectoryPoseToMsg(d, T, keys[k], pose);
+
+    auto &pose_stamped = path.poses[k];
+    pose_stamped.header = pose_array.header;
+    pose_stamped.pose = pose;
+
+    auto &node_msg = pose_graph.nodes[k];
+    node_msg.header = pose_array.header;
+    node_msg.robot_id = robotID;
+    node_msg.key = keys[k];
+    node_msg.pose = pose;
   }
+}
 
-  return m;
+void TrajectoryToMsgs(unsigned robotID,
+                      unsigned d,
+                      unsigned n,
+                      const Matrix &T,
+                      geometry_msgs::PoseArray &pose_array,
+                      nav_msgs::Path &path,
+                      pose_graph_tools_msgs::PoseGraph &pose_graph) {
+  std::vector<unsigned> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  TrajectoryToMsgs(robotID, d, n, T, keys, pose_array, path, pose_graph);
 }
 
 geometry_msgs::PoseArray TrajectoryToPoseArray(unsigned d,
                                                unsigned n,
                                                const Matrix &T) {
-  assert(d == 3);
-  assert(T.rows() == d);
-  assert(T.cols() == (d + 1) * n);
   geometry_msgs::PoseArray msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
-  for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Pose pose;
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-
-    // convert rotation to ROS message
-    pose.orientation = RotationToQuaternionMsg(Ri);
-
-    // convert translation to ROS message
-    pose.position = TranslationToPointMsg(ti);
-
-    msg.poses.push_back(pose);
-  }
+  TrajectoryToPoses(d, n, T, msg.poses);
   return msg;
 }
 
 nav_msgs::Path TrajectoryToPath(unsigned d, unsigned n, const Matrix &T) {
-  assert(d == 3);
-  assert(T.rows() == d);
-  assert(T.cols() == (d + 1) * n);
   nav_msgs::Path msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
+  std::vector<geometry_msgs::Pose> poses;
+  TrajectoryToPoses(d, n, T, poses);
+  msg.poses.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Pose pose;
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-
-    // convert rotation to ROS message
-    pose.orientation = RotationToQuaternionMsg(Ri);
-
-    // convert translation to ROS message
-    pose.position = TranslationToPointMsg(ti);
-
-    geometry_msgs::PoseStamped poseStamped;
-    poseStamped.header.frame_id = "/world";
-    poseStamped.header.stamp = ros::Time::now();
-    poseStamped.pose = pose;
-
-    msg.poses.push_back(poseStamped);
+    msg.poses[i].header = msg.header;
+    msg.poses[i].pose = poses[i];
   }
   return msg;
 }
@@ -210,13 +362,12 @@ sensor_msgs::PointCloud TrajectoryToPointCloud(unsigned d,
   sensor_msgs::PointCloud msg;
   msg.header.frame_id = "/world";
   msg.header.stamp = ros::Time::now();
+  msg.points.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    geometry_msgs::Point32 point;
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
-    point.x = ti(0);
-    point.y = ti(1);
-    point.z = ti(2);
-    msg.points.push_back(point);
+    const double *translation = T.data() + i * d * (d + 1) + d * d;
+    msg.points[i].x = translation[0];
+    msg.points[i].y = translation[1];
+    msg.points[i].z = translation[2];
   }
   return msg;
 }
@@ -225,42 +376,310 @@ pose_graph_tools_msgs::PoseGraph TrajectoryToPoseGraphMsg(unsigned robotID,
                                                           unsigned d,
                                                           unsigned n,
                                                           const Matrix &T) {
-  assert(d == 3);
-  assert(T.rows() == d);
-  assert(T.cols() == (d + 1) * n);
   pose_graph_tools_msgs::PoseGraph pose_graph_msg;
   pose_graph_msg.header.frame_id = "/world";
   pose_graph_msg.header.stamp = ros::Time::now();
+  std::vector<geometry_msgs::Pose> poses;
+  TrajectoryToPoses(d, n, T, poses);
+  pose_graph_msg.nodes.resize(n);
   for (size_t i = 0; i < n; ++i) {
-    pose_graph_tools_msgs::PoseGraphNode node_msg;
+    auto &node_msg = pose_graph_msg.nodes[i];
     node_msg.robot_id = robotID;
     node_msg.key = i;
-    node_msg.header.frame_id = "/world";
-    node_msg.header.stamp = pose_graph_msg.header.stamp;
+    node_msg.header = pose_graph_msg.header;
+    node_msg.pose = poses[i];
+  }
+  return pose_graph_msg;
+}
 
-    Matrix Ri = T.block(0, i * (d + 1), d, d);
-    Matrix ti = T.block(0, i * (d + 1) + d, d, 1);
+size_t computePublicPosesMsgSize(const PublicPoses &msg) {
+  return ros::serialization::serializationLength(msg);
+}
 
-    // convert rotation to ROS message
-    node_msg.pose.orientation = RotationToQuaternionMsg(Ri);
+void PoseDictToPackedMsg(const PoseDict &poseDict, PackedPublicPoses &msg) {
+  msg.pose_ids.clear();
+  msg.values.clear();
+  msg.values_float32.clear();
+  msg.values_fixed16.clear();
+  msg.encoding = PackedPublicPoses::FLOAT64;
+  msg.scale = 0;
+  msg.rows = 0;
+  msg.cols = 0;
+  msg.stride = 0;
+  if (poseDict.empty()) return;
+
+  const auto &firstPose = poseDict.begin()->second;
+  msg.rows = firstPose.r();
+  msg.cols = firstPose.d() + 1;
+  msg.stride = msg.rows * msg.cols;
+  msg.pose_ids.reserve(poseDict.size());
+  msg.values.resize(msg.stride * poseDict.size());
+
+  double *dst = msg.values.data();
+  for (const auto &it : poseDict) {
+    const auto &X = it.second.getData();
+    assert((size_t)X.rows() == msg.rows);
+    assert((size_t)X.cols() == msg.cols);
+    msg.pose_ids.push_back(it.first.frame_id);
+    std::memcpy(dst, X.data(), msg.stride * sizeof(double));
+    dst += msg.stride;
+  }
+}
 
-    // convert translation to ROS message
-    node_msg.pose.position = TranslationToPointMsg(ti);
+bool PoseDictFromPackedMsg(const PackedPublicPoses &msg, PoseDict &poseDict) {
+  poseDict.clear();
+  if (msg.stride != (size_t)msg.rows * msg.cols) return false;
+  size_t num_values = msg.stride * msg.pose_ids.size();
+
+  switch (msg.encoding) {
+    case PackedPublicPoses::FLOAT64: {
+      if (msg.values.size() != num_values) return false;
+      const double *src = msg.values.data();
+      for (const auto &frame_id : msg.pose_ids) {
+        const PoseID nID(msg.robot_id, frame_id);
+        const Eigen::Map<const Matrix> X(src, msg.rows, msg.cols);
+        poseDict.emplace(nID, Matrix(X));
+        src += msg.stride;
+      }
+      return true;
+    }
+    case PackedPublicPoses::FLOAT32: {
+      if (msg.values_float32.size() != num_values) return false;
+      const float *src = msg.values_float32.data();
+      for (const auto &frame_id : msg.pose_ids) {
+        const PoseID nID(msg.robot_id, frame_id);
+        const Eigen::Map<const Eigen::MatrixXf> X(src, msg.rows, msg.cols);
+        poseDict.emplace(nID, Matrix(X.cast<double>()));
+        src += msg.stride;
+      }
+      return true;
+    }
+    case PackedPublicPoses::FIXED16: {
+      if (msg.values_fixed16.size() != num_values) return false;
+      typedef Eigen::Matrix<int16_t, Eigen::Dynamic, Eigen::Dynamic> MatrixFixed16;
+      const int16_t *src = msg.values_fixed16.data();
+      for (const auto &frame_id : msg.pose_ids) {
+        const PoseID nID(msg.robot_id, frame_id);
+        const Eigen::Map<const MatrixFixed16> X(src, msg.rows, msg.cols);
+        poseDict.emplace(nID, Matrix(msg.scale * X.cast<double>()));
+        src += msg.stride;
+      }
+      return true;
+    }
+  }
+  return false;
+}
 
-    pose_graph_msg.nodes.push_back(node_msg);
+double compressPackedPublicPoses(PackedPublicPoses &msg,
+                                 uint8_t encoding,
+                                 double maxError) {
+  if (msg.encoding != PackedPublicPoses::FLOAT64 || msg.values.empty()) return 0;
+  const Eigen::Map<const Vector> values(msg.values.data(), msg.values.size());
+  // Casting NaN, Inf or out of range values is undefined, so keep FLOAT64 instead
+  if (!values.allFinite()) return 0;
+  const double max_abs = values.cwiseAbs().maxCoeff();
+
+  if (encoding == PackedPublicPoses::FIXED16) {
+    // Use a single quantization step for the entire message
+    const double int16_max = std::numeric_limits<int16_t>::max();
+    const double scale = max_abs > 0 ? max_abs / int16_max : 1.0;
+    const Vector scaled = (values / scale).array().round();
+    if (scale > 0 && scaled.allFinite() && scaled.cwiseAbs().maxCoeff() <= int16_max) {
+      Eigen::Matrix<int16_t, Eigen::Dynamic, 1> quantized = scaled.cast<int16_t>();
+      double error = (values - scale * quantized.cast<double>()).cwiseAbs().maxCoeff();
+      if (error <= maxError) {
+        msg.encoding = PackedPublicPoses::FIXED16;
+        msg.scale = scale;
+        msg.values_fixed16.assign(quantized.data(),
+                                  quantized.data() + quantized.size());
+        msg.values.clear();
+        return error;
+      }
+    }
+    // Fall back to a more precise encoding
+    encoding = PackedPublicPoses::FLOAT32;
   }
-  return pose_graph_msg;
+
+  if (encoding == PackedPublicPoses::FLOAT32 &&
+      max_abs <= std::numeric_limits<float>::max()) {
+    Eigen::VectorXf converted = values.cast<float>();
+    double error = (values - converted.cast<double>()).cwiseAbs().maxCoeff();
+    if (error <= maxError) {
+      msg.encoding = PackedPublicPoses::FLOAT32;
+      msg.values_float32.assign(converted.data(), converted.data() + converted.size());
+      msg.values.clear();
+      return error;
+    }
+  }
+
+  return 0;
 }
 
-size_t computePublicPosesMsgSize(const PublicPoses &msg) {
-  size_t bytes = 0;
-  bytes += sizeof(msg.robot_id);
-  bytes += sizeof(msg.instance_number);
-  bytes += sizeof(msg.iteration_number);
-  bytes += sizeof(msg.is_auxiliary);
-  bytes += sizeof(msg.pose_ids[0]) * msg.pose_ids.size();
-  bytes += sizeof(msg.poses[0]) * msg.poses.size();
-  return bytes;
+PoseDict filterChangedPoses(const PoseDict &poseDict,
+                            const PoseDict &reference,
+                            double tol) {
+  PoseDict changed;
+  for (const auto &it : poseDict) {
+    const auto &ref = reference.find(it.first);
+    if (ref == reference.end() ||
+        (it.second.getData() - ref->second.getData()).norm() > tol) {
+      changed.emplace(it.first, it.second);
+    }
+  }
+  return changed;
+}
+
+size_t computePackedPublicPosesMsgSize(const PackedPublicPoses &msg) {
+  return ros::serialization::serializationLength(msg);
+}
+
+std::vector<std::vector<unsigned>> greedyGraphColoring(
+    const std::map<unsigned, std::set<unsigned>> &adjacency) {
+  std::vector<unsigned> vertices;
+  for (const auto &it : adjacency) vertices.push_back(it.first);
+  // Ties are broken by vertex ID so that the coloring is deterministic
+  std::stable_sort(vertices.begin(), vertices.end(), [&](unsigned a, unsigned b) {
+    return adjacency.at(a).size() > adjacency.at(b).size();
+  });
+
+  std::map<unsigned, size_t> vertex_colors;
+  std::vector<std::vector<unsigned>> colors;
+  for (unsigned v : vertices) {
+    std::set<size_t> used_colors;
+    for (unsigned neighbor : adjacency.at(v)) {
+      const auto it = vertex_colors.find(neighbor);
+      if (it != vertex_colors.end()) used_colors.insert(it->second);
+    }
+    size_t color = 0;
+    while (used_colors.find(color) != used_colors.end()) color++;
+    vertex_colors[v] = color;
+    if (color == colors.size()) colors.emplace_back();
+    colors[color].push_back(v);
+  }
+  for (auto &color : colors) std::sort(color.begin(), color.end());
+  return colors;
+}
+
+std::vector<double> gradientNormSelectionWeights(
+    const std::vector<double> &gradient_norms) {
+  double max_known = 0;
+  for (double gradient_norm : gradient_norms) {
+    max_known = std::max(max_known, gradient_norm);
+  }
+  const double unknown_weight = max_known > 0 ? max_known : 1.0;
+  std::vector<double> weights;
+  weights.reserve(gradient_norms.size());
+  double total_weight = 0;
+  for (double gradient_norm : gradient_norms) {
+    weights.push_back(gradient_norm < 0 ? unknown_weight : gradient_norm);
+    total_weight += weights.back();
+  }
+  if (total_weight <= 0) weights.assign(gradient_norms.size(), 1.0);
+  return weights;
+}
+
+std::vector<PoseID> contiguousPoseAssignment(size_t num_poses, unsigned num_robots) {
+  std::vector<PoseID> assignment;
+  if (num_robots == 0 || num_poses < num_robots) return assignment;
+  const size_t num_poses_per_robot = num_poses / num_robots;
+  assignment.reserve(num_poses);
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    size_t startIdx = robot * num_poses_per_robot;
+    size_t endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+    if (robot == num_robots - 1) endIdx = num_poses;
+    for (size_t idx = startIdx; idx < endIdx; ++idx) {
+      assignment.emplace_back(robot, idx - startIdx);
+    }
+  }
+  return assignment;
+}
+
+std::vector<RobotMeasurements> splitDataset(
+    const std::vector<RelativeSEMeasurement> &dataset,
+    const std::vector<PoseID> &assignment,
+    unsigned num_robots) {
+  std::vector<RobotMeasurements> robot_measurements(num_robots);
+  for (const auto &mIn : dataset) {
+    const PoseID &src = assignment.at(mIn.p1);
+    const PoseID &dst = assignment.at(mIn.p2);
+    RelativeSEMeasurement m(src.robot_id,
+                            dst.robot_id,
+                            src.frame_id,
+                            dst.frame_id,
+                            mIn.R,
+                            mIn.t,
+                            mIn.kappa,
+                            mIn.tau);
+    auto &measurements = robot_measurements.at(src.robot_id);
+    if (src.robot_id == dst.robot_id) {
+      // Local indices of non-contiguous blocks may be consecutive without odometry
+      if (mIn.p1 + 1 == mIn.p2) {
+        measurements.odometry.push_back(m);
+      } else {
+        measurements.privateLoopClosures.push_back(m);
+      }
+    } else {
+      measurements.sharedLoopClosures.push_back(m);
+    }
+  }
+  return robot_measurements;
+}
+
+PoseArray warmStartTrajectory(
+    const PoseArray &T_prev,
+    unsigned num_poses,
+    const std::vector<RelativeSEMeasurement> &odometry,
+    const std::vector<RelativeSEMeasurement> &private_loop_closures) {
+  assert(T_prev.n() > 0 && T_prev.n() <= num_poses);
+  const unsigned d = T_prev.d();
+  // Measurement used to initialize each new pose from an earlier pose, preferring
+  // odometry. Measurements in the opposite direction are inverted.
+  std::vector<const RelativeSEMeasurement *> incoming(num_poses, nullptr);
+  std::vector<bool> inverted(num_poses, false);
+  for (const auto *measurements : {&odometry, &private_loop_closures}) {
+    for (const auto &m : *measurements) {
+      if (m.p1 < m.p2 && m.p2 < num_poses && !incoming[m.p2]) {
+        incoming[m.p2] = &m;
+      } else if (m.p2 < m.p1 && m.p1 < num_poses && !incoming[m.p1]) {
+        incoming[m.p1] = &m;
+        inverted[m.p1] = true;
+      }
+    }
+  }
+
+  PoseArray T(d, num_poses);
+  for (unsigned i = 0; i < T_prev.n(); ++i) {
+    T.pose(i) = T_prev.pose(i);
+  }
+  for (unsigned i = T_prev.n(); i < num_poses; ++i) {
+    const RelativeSEMeasurement *m = incoming[i];
+    if (!m) {
+      T.pose(i) = T.pose(i - 1);
+    } else if (!inverted[i]) {
+      T.rotation(i) = T.rotation(m->p1) * m->R;
+      T.translation(i) = T.translation(m->p1) + T.rotation(m->p1) * m->t;
+    } else {
+      T.rotation(i) = T.rotation(m->p2) * m->R.transpose();
+      T.translation(i) = T.translation(m->p2) - T.rotation(i) * m->t;
+    }
+  }
+  return T;
+}
+
+pose_graph_tools_msgs::PoseGraph poseGraphDelta(
+    const pose_graph_tools_msgs::PoseGraph &pose_graph,
+    uint64_t edge_watermark,
+    uint64_t node_watermark) {
+  if (edge_watermark > pose_graph.edges.size() ||
+      node_watermark > pose_graph.nodes.size()) {
+    edge_watermark = 0;
+    node_watermark = 0;
+  }
+  pose_graph_tools_msgs::PoseGraph delta;
+  delta.header = pose_graph.header;
+  delta.edges.assign(pose_graph.edges.begin() + edge_watermark, pose_graph.edges.end());
+  delta.nodes.assign(pose_graph.nodes.begin() + node_watermark, pose_graph.nodes.end());
+  return delta;
 }
 
 Status statusToMsg(const PGOAgentStatus &status) {
@@ -6,13 +6,35 @@
  * -------------------------------------------------------------------------- */
 #include <DPGO/PGOAgent.h>
 #include <DPGO/RelativeSEMeasurement.h>
+#include <dpgo_ros/AsyncBinaryLogger.h>
+#include <dpgo_ros/BandwidthMonitor.h>
+#include <dpgo_ros/LatencyHistogram.h>
+#include <dpgo_ros/PoseGraphROS.h>
+#include <dpgo_ros/SharedLoopClosureTracker.h>
+#include <dpgo_ros/dataset.h>
+#include <dpgo_ros/partition.h>
 #include <dpgo_ros/utils.h>
 #include <ros/ros.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 #include "gtest/gtest.h"
 
 using namespace dpgo_ros;
 
+// Unique directory per test, so that tests running in parallel do not share files
+std::filesystem::path makeTestDirectory() {
+  std::string pattern =
+      (std::filesystem::temp_directory_path() / "dpgo_ros_test_XXXXXX").string();
+  if (!mkdtemp(pattern.data())) return {};
+  return pattern;
+}
+
 TEST(UtilsTest, MatrixMsg) {
   DPGO::Matrix Mat(3, 3);
   Mat << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0;
@@ -25,6 +47,118 @@ TEST(UtilsTest, MatrixMsg) {
   ASSERT_LE((MatOut - Mat).norm(), 1e-6);
 }
 
+TEST(UtilsTest, PackedPublicPoses) {
+  unsigned r = 5;
+  unsigned d = 3;
+  PoseDict poseDict;
+  for (unsigned frame_id = 0; frame_id < 4; ++frame_id) {
+    DPGO::LiftedPose X(r, d);
+    X.setData(DPGO::Matrix::Random(r, d + 1));
+    poseDict.emplace(PoseID(1, 2 * frame_id), X);
+  }
+
+  PackedPublicPoses msg;
+  msg.robot_id = 1;
+  PoseDictToPackedMsg(poseDict, msg);
+  ASSERT_EQ(msg.rows, r);
+  ASSERT_EQ(msg.cols, d + 1);
+  ASSERT_EQ(msg.stride, r * (d + 1));
+  ASSERT_EQ(msg.pose_ids.size(), poseDict.size());
+  ASSERT_EQ(msg.values.size(), poseDict.size() * r * (d + 1));
+
+  PoseDict poseDictOut;
+  ASSERT_TRUE(PoseDictFromPackedMsg(msg, poseDictOut));
+  ASSERT_EQ(poseDictOut.size(), poseDict.size());
+  for (const auto &it : poseDict) {
+    const auto &itOut = poseDictOut.find(it.first);
+    ASSERT_TRUE(itOut != poseDictOut.end());
+    ASSERT_LE((itOut->second.getData() - it.second.getData()).norm(), 1e-12);
+  }
+
+  // Malformed message
+  msg.values.pop_back();
+  ASSERT_FALSE(PoseDictFromPackedMsg(msg, poseDictOut));
+}
+
+TEST(UtilsTest, CompressedPackedPublicPoses) {
+  unsigned r = 5;
+  unsigned d = 3;
+  PoseDict poseDict;
+  for (unsigned frame_id = 0; frame_id < 10; ++frame_id) {
+    DPGO::LiftedPose X(r, d);
+    X.setData(DPGO::Matrix::Random(r, d + 1));
+    X.translation() *= 10.0;
+    poseDict.emplace(PoseID(2, frame_id), X);
+  }
+
+  for (const uint8_t encoding : {PackedPublicPoses::FLOAT32, PackedPublicPoses::FIXED16}) {
+    double max_error = 1e-3;
+    PackedPublicPoses msg;
+    msg.robot_id = 2;
+    PoseDictToPackedMsg(poseDict, msg);
+    double error = compressPackedPublicPoses(msg, encoding, max_error);
+    ASSERT_EQ(msg.encoding, encoding);
+    ASSERT_TRUE(msg.values.empty());
+    ASSERT_LE(error, max_error);
+
+    PoseDict poseDictOut;
+    ASSERT_TRUE(PoseDictFromPackedMsg(msg, poseDictOut));
+    ASSERT_EQ(poseDictOut.size(), poseDict.size());
+    for (const auto &it : poseDict) {
+      const auto &XOut = poseDictOut.at(it.first).getData();
+      double pose_error = (XOut - it.second.getData()).cwiseAbs().maxCoeff();
+      ASSERT_LE(pose_error, error + 1e-12);
+    }
+  }
+
+  // Fall back to lossless encoding if the error bound cannot be satisfied
+  PackedPublicPoses msg;
+  PoseDictToPackedMsg(poseDict, msg);
+  double error = compressPackedPublicPoses(msg, PackedPublicPoses::FIXED16, 1e-12);
+  ASSERT_EQ(msg.encoding, PackedPublicPoses::FLOAT64);
+  ASSERT_EQ(error, 0);
+
+  // Non-finite values are never quantized
+  for (const double bad : {std::numeric_limits<double>::quiet_NaN(),
+                           std::numeric_limits<double>::infinity()}) {
+    PackedPublicPoses bad_msg;
+    PoseDictToPackedMsg(poseDict, bad_msg);
+    bad_msg.values[0] = bad;
+    ASSERT_EQ(compressPackedPublicPoses(bad_msg, PackedPublicPoses::FIXED16, 1.0), 0);
+    ASSERT_EQ(bad_msg.encoding, PackedPublicPoses::FLOAT64);
+    ASSERT_TRUE(bad_msg.values_fixed16.empty());
+  }
+
+  // Values beyond the float range are not encoded as FLOAT32
+  PackedPublicPoses large_msg;
+  PoseDictToPackedMsg(poseDict, large_msg);
+  large_msg.values[0] = 1e300;
+  compressPackedPublicPoses(large_msg, PackedPublicPoses::FLOAT32, 1e300);
+  ASSERT_EQ(large_msg.encoding, PackedPublicPoses::FLOAT64);
+}
+
+TEST(UtilsTest, FilterChangedPoses) {
+  unsigned r = 5;
+  unsigned d = 3;
+  PoseDict reference;
+  for (unsigned frame_id = 0; frame_id < 3; ++frame_id) {
+    DPGO::LiftedPose X(r, d);
+    X.setData(DPGO::Matrix::Random(r, d + 1));
+    reference.emplace(PoseID(0, frame_id), X);
+  }
+
+  PoseDict poseDict = reference;
+  poseDict.at(PoseID(0, 1)).translation()(0) += 1e-2;
+  poseDict.at(PoseID(0, 2)).translation()(0) += 1e-6;
+  DPGO::LiftedPose X(r, d);
+  poseDict.emplace(PoseID(0, 3), X);
+
+  PoseDict changed = filterChangedPoses(poseDict, reference, 1e-4);
+  ASSERT_EQ(changed.size(), 2);
+  ASSERT_TRUE(changed.find(PoseID(0, 1)) != changed.end());
+  ASSERT_TRUE(changed.find(PoseID(0, 3)) != changed.end());
+}
+
 TEST(UtilsTest, PoseGraphEdge) {
   size_t r1 = 0;
   size_t r2 = 1;
@@ -49,6 +183,590 @@ TEST(UtilsTest, PoseGraphEdge) {
   ASSERT_EQ(mOut.p2, p2);
   ASSERT_LE((R - mOut.R).norm(), 1e-6);
   ASSERT_LE((t - mOut.t).norm(), 1e-6);
+  ASSERT_DOUBLE_EQ(mOut.kappa, kappa);
+  ASSERT_DOUBLE_EQ(mOut.tau, tau);
+  ASSERT_FALSE(mOut.fixedWeight);
+
+  // Default weights without covariance
+  msg.covariance.fill(0);
+  mOut = RelativeMeasurementFromMsg(msg);
+  ASSERT_DOUBLE_EQ(mOut.kappa, 10000);
+  ASSERT_DOUBLE_EQ(mOut.tau, 100);
+
+  // Batch conversion reuses existing measurements
+  std::vector<pose_graph_tools_msgs::PoseGraphEdge> msgs;
+  RelativeMeasurementsToMsgs({m, m}, msgs);
+  msgs[1].key_from = 3;
+  msgs[1].key_to = 4;
+  msgs[1].robot_to = 0;
+  std::vector<DPGO::RelativeSEMeasurement> measurements;
+  RelativeMeasurementsFromMsgs(msgs, measurements);
+  ASSERT_EQ(measurements.size(), 2);
+  ASSERT_LE((R - measurements[0].R).norm(), 1e-6);
+  ASSERT_DOUBLE_EQ(measurements[0].kappa, kappa);
+  ASSERT_TRUE(measurements[1].fixedWeight);
+}
+
+TEST(UtilsTest, GreedyGraphColoring) {
+  // Chain 0 - 1 - 2 - 3 with an additional edge 1 - 3, and isolated vertex 4
+  std::map<unsigned, std::set<unsigned>> adjacency;
+  adjacency[0] = {1};
+  adjacency[1] = {0, 2, 3};
+  adjacency[2] = {1, 3};
+  adjacency[3] = {1, 2};
+  adjacency[4] = {};
+
+  const auto colors = greedyGraphColoring(adjacency);
+  ASSERT_EQ(colors.size(), 3);
+  ASSERT_EQ(colors[0], std::vector<unsigned>({1, 4}));
+
+  // Every vertex is colored exactly once and adjacent vertices have different colors
+  std::map<unsigned, size_t> vertex_colors;
+  for (size_t c = 0; c < colors.size(); ++c) {
+    for (unsigned v : colors[c]) {
+      ASSERT_TRUE(vertex_colors.emplace(v, c).second);
+    }
+  }
+  ASSERT_EQ(vertex_colors.size(), adjacency.size());
+  for (const auto &it : adjacency) {
+    for (unsigned neighbor : it.second) {
+      ASSERT_NE(vertex_colors.at(it.first), vertex_colors.at(neighbor));
+    }
+  }
+}
+
+TEST(UtilsTest, GradientNormSelectionWeights) {
+  std::vector<double> weights = gradientNormSelectionWeights({0.5, -1, 2.0, 0});
+  ASSERT_EQ(weights, std::vector<double>({0.5, 2.0, 2.0, 0}));
+
+  // Unknown gradient norms when no other robot reported a positive value
+  weights = gradientNormSelectionWeights({0, -1});
+  ASSERT_EQ(weights, std::vector<double>({0, 1.0}));
+
+  // All robots converged
+  weights = gradientNormSelectionWeights({0, 0, 0});
+  ASSERT_EQ(weights, std::vector<double>({1.0, 1.0, 1.0}));
+}
+
+TEST(UtilsTest, SplitDataset) {
+  ASSERT_TRUE(contiguousPoseAssignment(2, 3).empty());
+  // Robot 0: poses 0-1, robot 1: poses 2-3, robot 2: poses 4-6
+  const auto assignment = contiguousPoseAssignment(7, 3);
+  ASSERT_EQ(assignment.size(), 7);
+  ASSERT_TRUE(assignment[1] == PoseID(0, 1));
+  ASSERT_TRUE(assignment[2] == PoseID(1, 0));
+  ASSERT_TRUE(assignment[6] == PoseID(2, 2));
+
+  const DPGO::Matrix R = DPGO::Matrix::Identity(3, 3);
+  const DPGO::Matrix t = DPGO::Matrix::Zero(3, 1);
+  std::vector<DPGO::RelativeSEMeasurement> dataset;
+  dataset.emplace_back(0, 0, 0, 1, R, t, 1.0, 1.0);
+  dataset.emplace_back(0, 0, 1, 2, R, t, 1.0, 1.0);
+  dataset.emplace_back(0, 0, 2, 3, R, t, 1.0, 1.0);
+  dataset.emplace_back(0, 0, 4, 6, R, t, 1.0, 1.0);
+  dataset.emplace_back(0, 0, 5, 1, R, t, 1.0, 1.0);
+  const auto robot_measurements = splitDataset(dataset, assignment, 3);
+  ASSERT_EQ(robot_measurements.size(), 3);
+  ASSERT_EQ(robot_measurements[0].odometry.size(), 1);
+  ASSERT_EQ(robot_measurements[0].sharedLoopClosures.size(), 1);
+  ASSERT_EQ(robot_measurements[1].odometry.size(), 1);
+  ASSERT_EQ(robot_measurements[1].sharedLoopClosures.size(), 0);
+  ASSERT_EQ(robot_measurements[2].privateLoopClosures.size(), 1);
+  ASSERT_EQ(robot_measurements[2].sharedLoopClosures.size(), 1);
+
+  const auto &m = robot_measurements[2].sharedLoopClosures[0];
+  ASSERT_EQ(m.r1, 2);
+  ASSERT_EQ(m.p1, 1);
+  ASSERT_EQ(m.r2, 0);
+  ASSERT_EQ(m.p2, 1);
+
+  // Robot 0 owns poses 0, 1 and 4. The loop closure 1 - 4 joins consecutive local
+  // poses, but is not odometry.
+  const std::vector<PoseID> non_contiguous{
+      PoseID(0, 0), PoseID(0, 1), PoseID(1, 0), PoseID(1, 1), PoseID(0, 2)};
+  std::vector<DPGO::RelativeSEMeasurement> loop;
+  for (unsigned i = 0; i + 1 < 5; ++i) {
+    loop.emplace_back(0, 0, i, i + 1, R, t, 1.0, 1.0);
+  }
+  loop.emplace_back(0, 0, 1, 4, R, t, 1.0, 1.0);
+  const auto loop_measurements = splitDataset(loop, non_contiguous, 2);
+  ASSERT_EQ(loop_measurements[0].odometry.size(), 1);
+  ASSERT_EQ(loop_measurements[0].privateLoopClosures.size(), 1);
+  ASSERT_EQ(loop_measurements[0].privateLoopClosures[0].p1, 1);
+  ASSERT_EQ(loop_measurements[0].privateLoopClosures[0].p2, 2);
+  ASSERT_EQ(loop_measurements[0].sharedLoopClosures.size(), 1);
+  ASSERT_EQ(loop_measurements[1].odometry.size(), 1);
+  ASSERT_EQ(loop_measurements[1].sharedLoopClosures.size(), 1);
+}
+
+TEST(UtilsTest, MinCutPartition) {
+  // Odometry chain 0 - 1 - ... - 99, where the two ends of the trajectory are connected
+  // by loop closures. The best split is {0-24, 75-99} and {25-74}.
+  const DPGO::Matrix R = DPGO::Matrix::Identity(3, 3);
+  const DPGO::Matrix t = DPGO::Matrix::Zero(3, 1);
+  std::vector<DPGO::RelativeSEMeasurement> dataset;
+  for (unsigned i = 0; i + 1 < 100; ++i) {
+    dataset.emplace_back(0, 0, i, i + 1, R, t, 1.0, 1.0);
+  }
+  for (unsigned i = 0; i < 25; ++i) {
+    dataset.emplace_back(0, 0, i, 99 - i, R, t, 1.0, 1.0);
+  }
+  for (unsigned i = 25; i + 2 < 75; ++i) {
+    dataset.emplace_back(0, 0, i, i + 2, R, t, 1.0, 1.0);
+  }
+
+  ASSERT_TRUE(minCutPoseAssignment(2, dataset, 3, 0.05).empty());
+  const auto assignment = minCutPoseAssignment(100, dataset, 2, 0.05);
+  ASSERT_EQ(assignment.size(), 100);
+  std::vector<size_t> num_poses(2, 0);
+  for (const auto &pose_id : assignment) num_poses.at(pose_id.robot_id)++;
+  ASSERT_GE(num_poses[0], 47);
+  ASSERT_GE(num_poses[1], 47);
+
+  const auto cuts = computeEdgeCuts(assignment, dataset, 2);
+  const auto contiguous_cuts =
+      computeEdgeCuts(contiguousPoseAssignment(100, 2), dataset, 2);
+  ASSERT_EQ(contiguous_cuts[0], 28);
+  ASSERT_LE(cuts[0], 4);
+  ASSERT_EQ(cuts[0], cuts[1]);
+
+  // Local pose indices follow the global order
+  ASSERT_EQ(assignment[0].frame_id, 0);
+  ASSERT_EQ(assignment[99].robot_id, assignment[0].robot_id);
+}
+
+TEST(UtilsTest, DatasetLoader) {
+  const auto directory = makeTestDirectory();
+  ASSERT_FALSE(directory.empty());
+  const std::string filename = (directory / "dataset.g2o").string();
+  {
+    std::ofstream file(filename);
+    file << "VERTEX_SE3:QUAT 0 0 0 0 0 0 0 1\n\n";
+    // Information matrix diag(1, 1, 1, 2, 2, 2) with unnormalized quaternion
+    file << "EDGE_SE3:QUAT 0 1 1 2 3 0 0 0 2 1 0 0 0 0 0 1 0 0 0 0 1 0 0 0 2 0 0 2 0 "
+            "2\n";
+    file << "EDGE_SE3:QUAT 1 2 1 0 0 0 0 1 0 1 0 0 0 0 0 1 0 0 0 0 1 0 0 0 1 0 0 1 0 "
+            "1\r\n";
+    file << "EDGE_SE3:QUAT 0 3 1 0 0 0 0 1 0 1 0 0 0 0 0 1 0 0 0 0 1 0 0 0 1 0 0 1 0 1";
+  }
+
+  std::vector<DatasetEdge> edges;
+  size_t num_poses = 0;
+  ASSERT_TRUE(parseG2OFile(filename, edges, num_poses));
+  ASSERT_EQ(num_poses, 4);
+  ASSERT_EQ(edges.size(), 3);
+  ASSERT_EQ(edges[0].p1, 0);
+  ASSERT_EQ(edges[0].p2, 1);
+  ASSERT_DOUBLE_EQ(edges[0].translation[2], 3);
+  ASSERT_DOUBLE_EQ(edges[0].quaternion[3], 1);
+  ASSERT_DOUBLE_EQ(edges[0].tau, 1);
+  ASSERT_DOUBLE_EQ(edges[0].kappa, 1);
+  ASSERT_EQ(edges[2].p2, 3);
+  ASSERT_TRUE(edges[1].odometry);
+  ASSERT_FALSE(edges[2].odometry);
+
+  const auto msg = DatasetEdgeToMsg(edges[1]);
+  ASSERT_DOUBLE_EQ(msg.pose.orientation.z, 1);
+  ASSERT_DOUBLE_EQ(msg.pose.position.x, 1);
+  const auto m = DatasetEdgeToMeasurement(edges[1]);
+  ASSERT_NEAR(m.R(0, 0), -1, 1e-9);
+  ASSERT_DOUBLE_EQ(m.kappa, 0.5);
+  // Weights are sent as covariance
+  ASSERT_DOUBLE_EQ(RelativeMeasurementFromMsg(msg).kappa, 0.5);
+
+  // Same split as splitDataset: odometry first, shared loop closures at the source
+  const auto robot_edges = splitDatasetEdges(edges, contiguousPoseAssignment(4, 2), 2);
+  ASSERT_EQ(robot_edges[0].size(), 3);
+  ASSERT_TRUE(robot_edges[1].empty());
+  ASSERT_EQ(robot_edges[0][0].p2, 1);
+  ASSERT_EQ(robot_edges[0][1].r2, 1);
+  ASSERT_EQ(robot_edges[0][1].p2, 0);
+  ASSERT_EQ(robot_edges[0][2].p2, 1);
+  ASSERT_TRUE(robot_edges[0][0].odometry);
+  ASSERT_FALSE(robot_edges[0][1].odometry);
+  ASSERT_EQ(computeEdgeCuts(contiguousPoseAssignment(4, 2), poseEdges(edges), 2)[1], 2);
+
+  // Binary cache round trip
+  const std::string key = datasetCacheKey(filename, 2, "Contiguous", 0.05);
+  ASSERT_FALSE(key.empty());
+  ASSERT_NE(key, datasetCacheKey(filename, 2, "MinCut", 0.05));
+  const std::string cache_file = datasetCacheFile(directory.string(), filename, key);
+  ASSERT_TRUE(writeDatasetCache(cache_file, key, num_poses, robot_edges));
+  std::vector<std::vector<DatasetEdge>> cached_edges;
+  size_t cached_num_poses = 0;
+  ASSERT_TRUE(readDatasetCache(cache_file, key, cached_num_poses, cached_edges));
+  ASSERT_EQ(cached_num_poses, 4);
+  ASSERT_EQ(cached_edges.size(), 2);
+  ASSERT_EQ(cached_edges[0].size(), 3);
+  ASSERT_TRUE(cached_edges[1].empty());
+  ASSERT_EQ(cached_edges[0][2].r2, 1);
+  ASSERT_DOUBLE_EQ(cached_edges[0][0].translation[1], 2);
+  ASSERT_TRUE(cached_edges[0][0].odometry);
+  ASSERT_FALSE(readDatasetCache(cache_file, key + "x", cached_num_poses, cached_edges));
+
+  // Measurements written by PGOLogger
+  const std::string csv_filename = (directory / "measurements.csv").string();
+  {
+    std::ofstream file(csv_filename);
+    file << "robot_src,pose_src,robot_dst,pose_dst,qx,qy,qz,qw,tx,ty,tz,kappa,tau,"
+            "is_known_inlier,weight\n";
+    file << "1,0,2,5,0,0,0,1,1,2,3,10000,100,1,1\n";
+  }
+  ASSERT_TRUE(parseMeasurementsFile(csv_filename, edges));
+  ASSERT_EQ(edges.size(), 1);
+  ASSERT_EQ(edges[0].r1, 1);
+  ASSERT_EQ(edges[0].r2, 2);
+  ASSERT_EQ(edges[0].p2, 5);
+  ASSERT_DOUBLE_EQ(edges[0].kappa, 10000);
+
+  // Only 3D datasets are supported
+  {
+    std::ofstream file(filename);
+    file << "EDGE_SE2 0 1 1 0 0 1 0 0 1 0 1\n";
+  }
+  ASSERT_FALSE(parseG2OFile(filename, edges, num_poses));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(UtilsTest, WarmStartTrajectory) {
+  const unsigned d = 3;
+  PoseArray T_prev(d, 2);
+  for (unsigned i = 0; i < 2; ++i) {
+    T_prev.rotation(i) = Eigen::AngleAxisd(0.5 * i, Eigen::Vector3d::UnitZ()).matrix();
+    T_prev.translation(i) = Eigen::Vector3d(i, 0, 0);
+  }
+  // Odometry along x, rotating by 90 degrees around z
+  std::vector<RelativeSEMeasurement> odometry;
+  const Matrix R = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).matrix();
+  const Matrix t = Eigen::Vector3d(1, 0, 0);
+  for (unsigned i = 0; i + 1 < 4; ++i) {
+    odometry.emplace_back(0, 0, i, i + 1, R, t, 1.0, 1.0);
+  }
+
+  const PoseArray T = warmStartTrajectory(T_prev, 5, odometry);
+  ASSERT_EQ(T.n(), 5);
+  // Previous poses are kept
+  ASSERT_LE((T.pose(0) - T_prev.pose(0)).norm(), 1e-9);
+  ASSERT_LE((T.pose(1) - T_prev.pose(1)).norm(), 1e-9);
+  // New poses follow odometry
+  ASSERT_LE((T.rotation(2) - T_prev.rotation(1) * R).norm(), 1e-9);
+  const Vector t2 = T_prev.translation(1) + T_prev.rotation(1) * t;
+  ASSERT_LE((T.translation(2) - t2).norm(), 1e-9);
+  ASSERT_LE((T.rotation(3) - T_prev.rotation(1) * R * R).norm(), 1e-9);
+  // Pose without odometry copies the previous pose
+  ASSERT_LE((T.pose(4) - T.pose(3)).norm(), 1e-9);
+
+  // Pose 4 follows a loop closure to pose 4 from pose 2, given in the other direction
+  std::vector<RelativeSEMeasurement> loop_closures;
+  loop_closures.emplace_back(0, 0, 4, 2, R, t, 1.0, 1.0);
+  const PoseArray T_loop = warmStartTrajectory(T_prev, 5, odometry, loop_closures);
+  ASSERT_LE((T_loop.pose(3) - T.pose(3)).norm(), 1e-9);
+  ASSERT_LE((T_loop.rotation(4) * R - T_loop.rotation(2)).norm(), 1e-9);
+  const Vector t4 = T_loop.translation(4) + T_loop.rotation(4) * t;
+  ASSERT_LE((t4 - T_loop.translation(2)).norm(), 1e-9);
+}
+
+TEST(UtilsTest, PoseGraphDelta) {
+  pose_graph_tools_msgs::PoseGraph pose_graph;
+  for (unsigned i = 0; i < 5; ++i) {
+    PoseGraphEdge edge;
+    edge.key_from = i;
+    edge.key_to = i + 1;
+    pose_graph.edges.push_back(edge);
+    pose_graph_tools_msgs::PoseGraphNode node;
+    node.key = i;
+    pose_graph.nodes.push_back(node);
+  }
+
+  auto delta = poseGraphDelta(pose_graph, 0, 0);
+  ASSERT_EQ(delta.edges.size(), 5);
+  ASSERT_EQ(delta.nodes.size(), 5);
+
+  delta = poseGraphDelta(pose_graph, 3, 4);
+  ASSERT_EQ(delta.edges.size(), 2);
+  ASSERT_EQ(delta.edges[0].key_from, 3);
+  ASSERT_EQ(delta.nodes.size(), 1);
+  ASSERT_EQ(delta.nodes[0].key, 4);
+
+  delta = poseGraphDelta(pose_graph, 5, 5);
+  ASSERT_TRUE(delta.edges.empty());
+  ASSERT_TRUE(delta.nodes.empty());
+
+  // Watermarks ahead of the pose graph return the full pose graph
+  delta = poseGraphDelta(pose_graph, 6, 0);
+  ASSERT_EQ(delta.edges.size(), 5);
+  ASSERT_EQ(delta.nodes.size(), 5);
+}
+
+TEST(UtilsTest, LatencyHistogram) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(histogram.count(), 0);
+  ASSERT_EQ(histogram.percentileMs(0.5), 0);
+
+  for (int ms = 1; ms <= 100; ++ms) histogram.record(ms);
+  ASSERT_EQ(histogram.count(), 100);
+  ASSERT_DOUBLE_EQ(histogram.meanMs(), 50.5);
+  ASSERT_DOUBLE_EQ(histogram.maxMs(), 100);
+  ASSERT_NEAR(histogram.percentileMs(0.5), 50, 2.5);
+  ASSERT_NEAR(histogram.percentileMs(0.95), 95, 4.75);
+  ASSERT_NEAR(histogram.percentileMs(0.99), 99, 4.95);
+  ASSERT_LE(histogram.percentileMs(1), 100);
+  ASSERT_GE(histogram.percentileMs(0), 1);
+
+  histogram.clear();
+  ASSERT_EQ(histogram.count(), 0);
+  {
+    ScopedTimer timer(histogram);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_EQ(histogram.count(), 1);
+  ASSERT_GE(histogram.maxMs(), 5);
+}
+
+TEST(UtilsTest, AsyncBinaryLogger) {
+  const auto directory = makeTestDirectory();
+  ASSERT_FALSE(directory.empty());
+  const std::string binary_file = (directory / "dpgo_log.bin").string();
+  const std::string csv_file = (directory / "dpgo_log.csv").string();
+  const std::string long_text(300, 'x');
+
+  // Small ring buffer so that the producer has to wait for the writer thread
+  std::stringstream expected;
+  writeIterationLogHeader(expected);
+  {
+    AsyncBinaryLogger logger(8);
+    ASSERT_TRUE(logger.open(binary_file));
+    for (uint32_t iter = 0; iter < 100; ++iter) {
+      IterationLogEntry entry{
+          1, 0, 2, iter, 10, 100 * iter, 50 * iter, 0.25, 0.5 * iter, 1e-3, 0};
+      logger.logIteration(entry);
+      writeIterationLogEntry(expected, entry);
+    }
+    logger.logString("TERMINATE");
+    logger.logString(long_text);
+    logger.flush();
+    ASSERT_EQ(std::filesystem::file_size(binary_file),
+              16 + 104 * sizeof(IterationLogRecord));
+    // Remaining records are written on destruction
+    logger.logString("");
+  }
+  expected << "TERMINATE\n" << long_text << "\n\n";
+
+  ASSERT_TRUE(convertBinaryIterationLog(binary_file, csv_file));
+  std::ifstream csv(csv_file);
+  std::stringstream converted;
+  converted << csv.rdbuf();
+  ASSERT_EQ(converted.str(), expected.str());
+
+  // Log cut in the middle of the long text line
+  std::filesystem::resize_file(binary_file, 16 + 103 * sizeof(IterationLogRecord));
+  ASSERT_TRUE(convertBinaryIterationLog(binary_file, csv_file));
+  std::ifstream truncated_csv(csv_file);
+  std::stringstream truncated;
+  truncated << truncated_csv.rdbuf();
+  const std::string expected_str = expected.str();
+  const std::string expected_truncated =
+      expected_str.substr(0, expected_str.size() - long_text.size() - 2) +
+      long_text.substr(0, 2 * IterationLogRecord::kMaxTextLength) + "\n";
+  ASSERT_EQ(truncated.str(), expected_truncated);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(UtilsTest, BandwidthMonitor) {
+  using Direction = BandwidthMonitor::Direction;
+  BandwidthMonitor monitor;
+  monitor.record(Direction::Sent, "public_poses", 1, 100);
+  monitor.record(Direction::Sent, "public_poses", 1, 100);
+  monitor.record(Direction::Sent, "status", BandwidthMonitor::kAllRobots, 40);
+  monitor.record(Direction::Received, "public_poses", 1, 300);
+  ASSERT_EQ(monitor.totalBytes(Direction::Sent), 240);
+  ASSERT_EQ(monitor.totalBytes(Direction::Received), 300);
+
+  // No rates without a previous call
+  auto links = monitor.statistics(10);
+  ASSERT_EQ(links.size(), 3);
+  for (const auto &link : links) ASSERT_EQ(link.bytesPerSec, 0);
+  const auto &sent = links[0];
+  ASSERT_EQ(sent.direction, Direction::Sent);
+  ASSERT_EQ(sent.topic, "public_poses");
+  ASSERT_EQ(sent.peer, 1);
+  ASSERT_EQ(sent.bytes, 200);
+  ASSERT_EQ(sent.messages, 2);
+
+  // Rates since the previous call
+  monitor.record(Direction::Sent, "public_poses", 1, 100);
+  monitor.record(Direction::Received, "command", 0, 20);
+  links = monitor.statistics(12);
+  ASSERT_EQ(links.size(), 4);
+  for (const auto &link : links) {
+    if (link.direction == Direction::Sent && link.topic == "public_poses") {
+      ASSERT_EQ(link.bytes, 300);
+      ASSERT_DOUBLE_EQ(link.bytesPerSec, 50);
+      ASSERT_DOUBLE_EQ(link.messagesPerSec, 0.5);
+    } else if (link.topic == "command") {
+      ASSERT_DOUBLE_EQ(link.bytesPerSec, 10);
+    } else {
+      ASSERT_EQ(link.bytesPerSec, 0);
+    }
+  }
+
+  monitor.clear();
+  ASSERT_EQ(monitor.totalBytes(Direction::Sent), 0);
+  ASSERT_TRUE(monitor.statistics(14).empty());
+}
+
+TEST(UtilsTest, SharedLoopClosureTracker) {
+  const DPGO::EdgeID e1(DPGO::PoseID(0, 1), DPGO::PoseID(1, 2));
+  const DPGO::EdgeID e2(DPGO::PoseID(0, 3), DPGO::PoseID(1, 4));
+  const DPGO::EdgeID e3(DPGO::PoseID(0, 5), DPGO::PoseID(2, 6));
+  SharedLoopClosureTracker tracker;
+  ASSERT_FALSE(tracker.updateEpoch(1, 10));
+  ASSERT_FALSE(tracker.updateEpoch(2, 20));
+
+  // Round 1: messages are acknowledged in order
+  tracker.addPending(1, 1, {e1});
+  tracker.addPending(1, 2, {e2});
+  tracker.addPending(2, 2, {e3});
+  tracker.acknowledge(1, 1);
+  tracker.acknowledge(2, 2);
+  ASSERT_TRUE(tracker.isAcknowledged(1, e1));
+  ASSERT_FALSE(tracker.isAcknowledged(1, e2));
+  ASSERT_TRUE(tracker.isAcknowledged(2, e3));
+
+  // Round 2: unacknowledged messages of the previous round are dropped
+  tracker.clearPending();
+  tracker.acknowledge(1, 2);
+  ASSERT_FALSE(tracker.isAcknowledged(1, e2));
+  ASSERT_FALSE(tracker.updateEpoch(1, 10));
+  ASSERT_TRUE(tracker.isAcknowledged(1, e1));
+
+  // Robot 1 restarts between rounds: its acknowledgements and pending messages are
+  // discarded, while those of robot 2 are kept
+  tracker.clearPending();
+  tracker.addPending(1, 3, {e2});
+  ASSERT_TRUE(tracker.updateEpoch(1, 11));
+  ASSERT_FALSE(tracker.isAcknowledged(1, e1));
+  tracker.acknowledge(1, 3);
+  ASSERT_FALSE(tracker.isAcknowledged(1, e2));
+  ASSERT_TRUE(tracker.isAcknowledged(2, e3));
+  tracker.addPending(1, 4, {e1, e2});
+  tracker.acknowledge(1, 4);
+  ASSERT_TRUE(tracker.isAcknowledged(1, e1));
+  ASSERT_TRUE(tracker.isAcknowledged(1, e2));
+
+  // Complete reset of this robot keeps the epochs of other robots
+  tracker.clear();
+  ASSERT_FALSE(tracker.isAcknowledged(1, e1));
+  ASSERT_FALSE(tracker.isAcknowledged(2, e3));
+  ASSERT_FALSE(tracker.updateEpoch(1, 11));
+  ASSERT_NE(SharedLoopClosureTracker::newEpoch(), 0u);
+}
+
+TEST(UtilsTest, SharedLoopClosureBlock) {
+  const unsigned r = 5;
+  const unsigned d = 3;
+  const DPGO::Matrix R =
+      Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+  const DPGO::Matrix t = Eigen::Vector3d(1.0, -2.0, 0.5);
+  const DPGO::RelativeSEMeasurement m(0, 1, 7, 3, R, t, 10.0, 2.0);
+  // Lifted local pose [Y p]; the neighbor pose is set to zero so that the cost only
+  // depends on the quadratic term of the local pose
+  const DPGO::Matrix X = DPGO::Matrix::Random(r, d + 1);
+  const DPGO::Matrix Y = X.leftCols(d);
+  const DPGO::Matrix p = X.rightCols(1);
+
+  // Outgoing edge: cost kappa |Y R|^2 + tau |p + Y t|^2
+  DPGO::Matrix block = PoseGraphROS::sharedLoopClosureBlock(m, 0);
+  double cost = m.kappa * (Y * R).squaredNorm() + m.tau * (p + Y * t).squaredNorm();
+  ASSERT_NEAR((X * block * X.transpose()).trace(), cost, 1e-9);
+
+  // Incoming edge: cost kappa |Y|^2 + tau |p|^2
+  block = PoseGraphROS::sharedLoopClosureBlock(m, 1);
+  cost = m.kappa * Y.squaredNorm() + m.tau * p.squaredNorm();
+  ASSERT_NEAR((X * block * X.transpose()).trace(), cost, 1e-9);
+}
+
+TEST(UtilsTest, IncrementalSharedLoopClosureWeight) {
+  const unsigned r = 5;
+  const unsigned d = 3;
+  const DPGO::Matrix R =
+      Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+  const DPGO::Matrix t = Eigen::Vector3d(1.0, -2.0, 0.5);
+  PoseGraphROS pose_graph(0, r, d);
+  for (unsigned i = 0; i + 1 < 4; ++i) {
+    pose_graph.addMeasurement(DPGO::RelativeSEMeasurement(0, 0, i, i + 1, R, t, 1, 1));
+  }
+  pose_graph.addMeasurement(DPGO::RelativeSEMeasurement(0, 0, 0, 3, R, t, 1, 1));
+  // Outgoing and incoming shared loop closures
+  pose_graph.addMeasurement(DPGO::RelativeSEMeasurement(0, 1, 2, 0, R, t, 10, 2));
+  pose_graph.addMeasurement(DPGO::RelativeSEMeasurement(1, 0, 4, 1, R, t, 5, 3));
+  pose_graph.useInactiveNeighbors(true);
+  pose_graph.quadraticMatrix();
+
+  ASSERT_TRUE(
+      pose_graph.setSharedLoopClosureWeight(PoseID(0, 2), PoseID(1, 0), 0.3, false));
+  ASSERT_TRUE(
+      pose_graph.setSharedLoopClosureWeight(PoseID(1, 4), PoseID(0, 1), 0.0, false));
+  ASSERT_FALSE(
+      pose_graph.setSharedLoopClosureWeight(PoseID(0, 0), PoseID(0, 1), 0.5, false));
+  ASSERT_EQ(pose_graph.numIncrementalUpdates(), 2);
+  const DPGO::Matrix Q_incremental = DPGO::Matrix(pose_graph.quadraticMatrix());
+
+  pose_graph.clearDataMatrices();
+  const DPGO::Matrix Q_rebuilt = DPGO::Matrix(pose_graph.quadraticMatrix());
+  ASSERT_EQ(Q_incremental.rows(), Q_rebuilt.rows());
+  ASSERT_LE((Q_incremental - Q_rebuilt).cwiseAbs().maxCoeff(), 1e-9);
+}
+
+TEST(UtilsTest, TrajectoryToMsgs) {
+  const unsigned d = 3;
+  const unsigned n = 20;
+  DPGO::Matrix T(d, (d + 1) * n);
+  for (unsigned i = 0; i < n; ++i) {
+    const Eigen::Quaterniond q = Eigen::Quaterniond::UnitRandom();
+    T.block(0, i * (d + 1), d, d) = q.toRotationMatrix();
+    T.col(i * (d + 1) + d) = Eigen::Vector3d::Random();
+  }
+
+  geometry_msgs::PoseArray pose_array;
+  nav_msgs::Path path;
+  pose_graph_tools_msgs::PoseGraph pose_graph;
+  TrajectoryToMsgs(7, d, n, T, pose_array, path, pose_graph);
+  ASSERT_EQ(pose_array.poses.size(), n);
+  ASSERT_EQ(path.poses.size(), n);
+  ASSERT_EQ(pose_graph.nodes.size(), n);
+  for (unsigned i = 0; i < n; ++i) {
+    const auto &pose = pose_array.poses[i];
+    ASSERT_LE((RotationFromPoseMsg(pose) - T.block(0, i * (d + 1), d, d)).norm(), 1e-9);
+    ASSERT_LE((TranslationFromPoseMsg(pose) - T.col(i * (d + 1) + d)).norm(), 1e-12);
+    ASSERT_EQ(path.poses[i].pose.orientation.w, pose.orientation.w);
+    ASSERT_EQ(path.poses[i].pose.position.x, pose.position.x);
+    ASSERT_EQ(pose_graph.nodes[i].robot_id, 7);
+    ASSERT_EQ(pose_graph.nodes[i].key, i);
+    ASSERT_EQ(pose_graph.nodes[i].pose.orientation.x, pose.orientation.x);
+  }
+
+  // Same poses as the individual conversions
+  const auto single = TrajectoryToPoseArray(d, n, T);
+  ASSERT_EQ(single.poses[3].orientation.z, pose_array.poses[3].orientation.z);
+
+  // Keyframes of a straight line with 0.1 spacing and one rotated pose
+  for (unsigned i = 0; i < n; ++i) {
+    T.block(0, i * (d + 1), d, d).setIdentity();
+    T.col(i * (d + 1) + d) = Eigen::Vector3d(0.1 * i, 0, 0);
+  }
+  T.block(0, 5 * (d + 1), d, d) =
+      Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  ASSERT_EQ(TrajectoryKeyframes(d, n, T, 0, 0).size(), n);
+  const std::vector<unsigned> distance_keys = {0, 6, 12, 18, 19};
+  ASSERT_EQ(TrajectoryKeyframes(d, n, T, 0.55, 0), distance_keys);
+  const std::vector<unsigned> keys = {0, 5, 6, 12, 18, 19};
+  ASSERT_EQ(TrajectoryKeyframes(d, n, T, 0.55, 0.3), keys);
+  TrajectoryToMsgs(7, d, n, T, keys, pose_array, path, pose_graph);
+  ASSERT_EQ(pose_array.poses.size(), keys.size());
+  ASSERT_EQ(path.poses.size(), keys.size());
+  ASSERT_EQ(pose_graph.nodes[2].key, 6);
+  ASSERT_DOUBLE_EQ(pose_graph.nodes[2].pose.position.x, 0.6);
 }
 
 TEST(UtilsTest, StatusMsg) {